@@ -0,0 +1,99 @@
+#pragma once
+
+/**
+ * Steady-state insert/erase churn (-churn): a workload that keeps the data
+ * structure at a constant size while it retires nodes as fast as updates
+ * can, to stress the memory reclaimer and the pool under sustained load.
+ *
+ * Keys are drawn uniformly from [0, churn_range), where churn_range is
+ * churn_range_factor (-churn_range, default 2) times the number of keys
+ * prefilled. The live keys are kept in churn_keys, one slot per key. In a
+ * prefill or phase with T threads, thread t owns the slots
+ * [n * t / T, n * (t + 1) / T), and only the owner of a slot inserts or
+ * erases its key, so every slot always holds a key that is in the data
+ * structure. With probability churn_update (-churn), an operation is an
+ * update of a random slot the thread owns: it inserts a fresh key (drawing
+ * again while the key is present), then erases the key of the slot. The data
+ * structure thus has n keys again after every update. Otherwise, it is a get
+ * of a random key of the range, which is present with probability
+ * 1 / churn_range_factor. An update counts as two operations, an insert and
+ * a remove.
+ *
+ * -churn enables the memory samples of mem_accountant.h. After each phase,
+ * churn_phase_print reports the updates per second, the nodes the reclaimer
+ * freed per second (to the allocator: with a pool, only the nodes the pool
+ * gives back are counted), the nodes in limbo at the end and at the peak of
+ * the phase, and how much the resident set grew over the phase, which
+ * levels off once the reclaimer keeps up.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+
+#include "latency.h"
+#include "mem_accountant.h"
+#include "zipf.h"
+
+double churn_update = -1;   // -churn: fraction of operations that are updates, < 0 if disabled
+double churn_range_factor = 2;
+int64_t churn_range = 0;
+int64_t churn_n = 0;
+int64_t * churn_keys = NULL;
+
+static inline bool churn_enabled() {
+    return churn_update >= 0;
+}
+
+// allocates the slots of n keys before the prefill. they are touched here,
+// before mem_attach takes its baseline, so that they do not show up as
+// allocator overhead.
+void churn_init(int64_t n) {
+    churn_n = n;
+    churn_range = (int64_t) (churn_range_factor * n);
+    churn_keys = new int64_t[n];
+    memset(churn_keys, 0, n * sizeof(int64_t));
+}
+
+void churn_free() {
+    delete[] churn_keys;
+    churn_keys = NULL;
+}
+
+// the first slot owned by thread t of tnum (and the end of the slots of t - 1)
+static inline int64_t churn_slot_begin(int t, int tnum) {
+    return churn_n * t / tnum;
+}
+
+static inline int64_t churn_random_key(int tid) {
+    return rand_range(tid, churn_range);
+}
+
+void churn_print() {
+    std::cout << "churn_update=" << churn_update << " churn_range=" << churn_range
+              << " churn_range_factor=" << churn_range_factor << std::endl;
+}
+
+// prints the reclamation statistics of the phase tnum threads just finished.
+// must follow mem_phase_print, and the phase must have started with mem_phase_begin.
+void churn_phase_print(int tnum) {
+    uint64_t updates = 0;
+    for (int tid = 0; tid < tnum; tid++)
+        if (lat_data[tid] != NULL) updates += lat_data[tid]->hist[remove_t].count;
+    double seconds = (exp_end_ns - exp_start_ns) / 1e9;
+    if (seconds <= 0) seconds = 1e-9;
+    const mem_sample & first = mem_phase_first;
+    const mem_sample & last = mem_phase_last;
+    long long freed = last.freed - first.freed;
+    const double mb = 1024.0 * 1024;
+    double growth = (last.rss - first.rss) / mb;
+    std::cout << "Churn: updates=" << updates << " update_mops=" << updates / seconds / 1e6
+              << " freed_nodes=" << freed << " freed_mnodes_per_s=" << freed / seconds / 1e6
+              << " limbo_nodes=" << last.limbo << " limbo_peak_nodes=" << mem_phase_peak_limbo
+              << " limbo_peak_mb=" << mem_phase_peak_limbo * mem_node_bytes / mb
+              << " rss_start_mb=" << first.rss / mb << " rss_end_mb=" << last.rss / mb
+              << " rss_growth_mb=" << growth << " rss_growth_mb_per_s=" << growth / seconds
+              << " keys_start=" << first.keys << " keys_end=" << last.keys << std::endl;
+}
@@ -0,0 +1,319 @@
+#pragma once
+
+/**
+ * Loading real key sets (-file) for the prefill and the measured phases.
+ *
+ * Formats (-format, detected from the file by default):
+ *   sosd   the SOSD benchmark format: a uint64_t count, then that many
+ *          uint64_t keys (e.g. books_200M_uint64, fb_200M_uint64)
+ *   i64    raw native int64_t keys, as written by gen_ops -load
+ *   text   one decimal key per line (.txt and .csv files)
+ * A binary file is taken to be SOSD if its first word is the number of
+ * words that follow it, otherwise raw i64.
+ *
+ * Keys are read by all threads in parallel into memory. Keys outside
+ * [0, key_range) cannot be stored by the driver and are dropped (and
+ * counted). Optionally, duplicates are then removed (-dedupe, which sorts
+ * the keys), and the keys are shuffled (-shuffle) with the per-thread
+ * generators of zipf.h, so that a run with -seed uses the same order.
+ *
+ * dataset_split then cuts the keys into the prefill, read and insert sets
+ * of -split p,r,i (fractions of the keys): the first p are prefilled, the
+ * next i are inserted by the insert phase, and the read phase searches an
+ * evenly spaced sample of r of the prefilled keys, so reads hit.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "timed_run.h"
+#include "zipf.h"
+
+#define DATASET_AUTO 0
+#define DATASET_I64 1
+#define DATASET_SOSD 2
+#define DATASET_TEXT 3
+const char * const dataset_format_names[] = {"auto", "i64", "sosd", "text"};
+
+int dataset_format = DATASET_AUTO;
+bool dataset_dedupe = false;
+bool dataset_shuffle = false;
+double dataset_split_fractions[3] = {0, 0, 0};   // prefill, read, insert; all 0 without -split
+
+struct dataset {
+    int64_t * keys;     // owned, n keys
+    int64_t n;
+    int64_t dropped;    // keys outside the key range
+    int64_t duplicates; // removed by dedupe
+};
+
+bool dataset_parse_format(const char * name) {
+    for (int i = 0; i < 4; i++) {
+        if (strcmp(name, dataset_format_names[i]) == 0) {
+            dataset_format = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// parses -split p,r,i
+bool dataset_parse_split(const char * spec) {
+    double f[3];
+    if (sscanf(spec, "%lf,%lf,%lf", &f[0], &f[1], &f[2]) != 3) return false;
+    if (f[0] < 0 || f[1] < 0 || f[2] < 0 || f[0] + f[2] > 1 + 1e-9 || f[1] > f[0] + 1e-9) return false;
+    for (int i = 0; i < 3; i++) dataset_split_fractions[i] = f[i];
+    return true;
+}
+
+// sorts keys[0,n) with tnum threads: each sorts a slice, then slices are merged pairwise
+void parallel_sort_i64(const int tnum, int64_t * keys, int64_t n) {
+    std::vector<int64_t> bounds(tnum + 1);
+    for (int i = 0; i <= tnum; i++) bounds[i] = n * i / tnum;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < tnum; i++)
+        threads.emplace_back([=, &bounds]() { std::sort(keys + bounds[i], keys + bounds[i+1]); });
+    for (auto & t : threads) t.join();
+    for (int width = 1; width < tnum; width *= 2) {
+        threads.clear();
+        for (int i = 0; i + width < tnum; i += 2 * width) {
+            int64_t * first = keys + bounds[i];
+            int64_t * middle = keys + bounds[i + width];
+            int64_t * last = keys + bounds[std::min(i + 2 * width, tnum)];
+            threads.emplace_back([=]() { std::inplace_merge(first, middle, last); });
+        }
+        for (auto & t : threads) t.join();
+    }
+}
+
+// runs f(t, begin, end) on tnum threads, thread t getting the t'th of tnum equal slices of [0,n)
+template<typename F>
+static void dataset_parallel_for(const int tnum, int64_t n, F f) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < tnum; t++)
+        threads.emplace_back([=, &f]() { f(t, n * t / tnum, n * (t + 1) / tnum); });
+    for (auto & t : threads) t.join();
+}
+
+static int dataset_detect_format(const std::string & name, int fd, int64_t size) {
+    size_t dot = name.rfind('.');
+    std::string ext = (dot == std::string::npos) ? "" : name.substr(dot + 1);
+    if (ext == "txt" || ext == "csv") return DATASET_TEXT;
+    uint64_t count;
+    if (size >= 8 && (size - 8) % 8 == 0 && pread(fd, &count, 8, 0) == 8 && count == (uint64_t) (size - 8) / 8)
+        return DATASET_SOSD;
+    return DATASET_I64;
+}
+
+// keeps the keys of src[0,n) that are in [0, key_range) at the front of dst, and returns how many
+template<typename T>
+static int64_t dataset_filter(const T * src, int64_t n, int64_t * dst, int64_t key_range) {
+    int64_t kept = 0;
+    for (int64_t i = 0; i < n; i++) {
+        if (src[i] >= 0 && (uint64_t) src[i] < (uint64_t) key_range) dst[kept++] = (int64_t) src[i];
+    }
+    return kept;
+}
+
+// parses the decimal keys on the lines that start in text[begin,end) into out
+static void dataset_parse_text(const char * text, int64_t size, int64_t begin, int64_t end,
+                               std::vector<int64_t> & out, int64_t key_range, int64_t * dropped) {
+    // a line belongs to the slice its first character is in
+    while (begin > 0 && begin < end && text[begin - 1] != '\n') begin++;
+    int64_t i = begin;
+    while (i < end) {
+        int64_t line_end = i;
+        while (line_end < size && text[line_end] != '\n') line_end++;
+        std::string line(text + i, line_end - i);
+        i = line_end + 1;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos) continue;
+        char * rest;
+        errno = 0;
+        bool negative = line[first] == '-';
+        uint64_t v = strtoull(line.c_str() + first, &rest, 10);
+        if (rest == line.c_str() + first || (*rest != '\0' && *rest != '\r' && *rest != ',' && *rest != ' ')) {
+            fprintf(stderr, "Error: bad key \"%s\" in text dataset\n", line.c_str());
+            exit(EXIT_FAILURE);
+        }
+        if (negative || errno == ERANGE || v >= (uint64_t) key_range) (*dropped)++;
+        else out.push_back((int64_t) v);
+    }
+}
+
+static void dataset_load_text(dataset * ds, int fd, int64_t size, const int tnum, int64_t key_range) {
+    const char * text = (const char *) mmap(0, size, PROT_READ, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (text == MAP_FAILED) {
+        perror("Error mmapping the dataset");
+        exit(EXIT_FAILURE);
+    }
+    std::vector<std::vector<int64_t>> parts(tnum);
+    std::vector<int64_t> dropped(tnum, 0);
+    dataset_parallel_for(tnum, size, [&](int t, int64_t begin, int64_t end) {
+        dataset_parse_text(text, size, begin, end, parts[t], key_range, &dropped[t]);
+    });
+    munmap((void *) text, size);
+    ds->n = 0;
+    for (int t = 0; t < tnum; t++) {
+        ds->n += parts[t].size();
+        ds->dropped += dropped[t];
+    }
+    ds->keys = new int64_t[std::max(ds->n, (int64_t) 1)];
+    int64_t next = 0;
+    for (int t = 0; t < tnum; t++) {
+        memcpy(ds->keys + next, parts[t].data(), parts[t].size() * sizeof(int64_t));
+        next += parts[t].size();
+        std::vector<int64_t>().swap(parts[t]);
+    }
+}
+
+// reads the 8 byte keys of a binary dataset from byte offset, each thread a slice
+static void dataset_load_binary(dataset * ds, int fd, int64_t offset, int64_t count, bool is_unsigned,
+                                const int tnum, int64_t key_range) {
+    ds->keys = new int64_t[std::max(count, (int64_t) 1)];
+    std::vector<int64_t> kept(tnum);
+    dataset_parallel_for(tnum, count, [&](int t, int64_t begin, int64_t end) {
+        const int64_t block = 1 << 16;
+        std::vector<uint64_t> buf(block);
+        int64_t out = begin;
+        for (int64_t i = begin; i < end; i += block) {
+            int64_t len = std::min(block, end - i);
+            ssize_t bytes = pread(fd, buf.data(), len * 8, offset + i * 8);
+            if (bytes != len * 8) {
+                perror("Error reading the dataset");
+                exit(EXIT_FAILURE);
+            }
+            if (is_unsigned) out += dataset_filter(buf.data(), len, ds->keys + out, key_range);
+            else out += dataset_filter((const int64_t *) buf.data(), len, ds->keys + out, key_range);
+        }
+        kept[t] = out - begin;
+    });
+    // close the gaps left by dropped keys
+    ds->n = kept[0];
+    for (int t = 1; t < tnum; t++) {
+        memmove(ds->keys + ds->n, ds->keys + count * t / tnum, kept[t] * sizeof(int64_t));
+        ds->n += kept[t];
+    }
+    ds->dropped = count - ds->n;
+}
+
+// uniform parallel shuffle: every thread sends each key of its slice to a random
+// thread's bucket, then every thread shuffles its bucket with Fisher-Yates
+static void dataset_shuffle_keys(dataset * ds, const int tnum) {
+    int64_t n = ds->n;
+    uint8_t * bucket_of = new uint8_t[std::max(n, (int64_t) 1)];
+    std::vector<std::vector<int64_t>> counts(tnum, std::vector<int64_t>(tnum, 0));
+    for (int t = 0; t < tnum; t++) seed_and_print(t);
+    dataset_parallel_for(tnum, n, [&](int t, int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+            bucket_of[i] = (uint8_t) rand_range(t, tnum);
+            counts[t][bucket_of[i]]++;
+        }
+    });
+    // bucket b holds the keys of thread 0, then thread 1, ... that were sent to b
+    std::vector<int64_t> bucket_begin(tnum + 1, 0);
+    std::vector<std::vector<int64_t>> next(tnum, std::vector<int64_t>(tnum));
+    int64_t pos = 0;
+    for (int b = 0; b < tnum; b++) {
+        bucket_begin[b] = pos;
+        for (int t = 0; t < tnum; t++) {
+            next[t][b] = pos;
+            pos += counts[t][b];
+        }
+    }
+    bucket_begin[tnum] = pos;
+    int64_t * out = new int64_t[std::max(n, (int64_t) 1)];
+    dataset_parallel_for(tnum, n, [&](int t, int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) out[next[t][bucket_of[i]]++] = ds->keys[i];
+    });
+    dataset_parallel_for(tnum, tnum, [&](int t, int64_t, int64_t) {
+        int64_t * a = out + bucket_begin[t];
+        for (int64_t i = bucket_begin[t + 1] - bucket_begin[t] - 1; i > 0; i--)
+            std::swap(a[i], a[rand_range(t, i + 1)]);
+    });
+    delete[] bucket_of;
+    delete[] ds->keys;
+    ds->keys = out;
+}
+
+// loads a dataset (see the top of this file) with tnum threads, and dedupes and
+// shuffles it if asked to. free it with dataset_free.
+dataset dataset_load(const std::string & name, const int tnum, int64_t key_range) {
+    dataset ds;
+    ds.keys = NULL;
+    ds.n = ds.dropped = ds.duplicates = 0;
+    int fd = open(name.c_str(), O_RDONLY);
+    struct stat fileInfo;
+    if (fd == -1 || fstat(fd, &fileInfo) == -1) {
+        perror("Error opening the dataset");
+        exit(EXIT_FAILURE);
+    }
+    int64_t size = fileInfo.st_size;
+    int format = (dataset_format == DATASET_AUTO) ? dataset_detect_format(name, fd, size) : dataset_format;
+    uint64_t t0 = exp_now_ns();
+    if (format == DATASET_TEXT) {
+        if (size > 0) dataset_load_text(&ds, fd, size, tnum, key_range);
+    }
+    else {
+        int64_t offset = (format == DATASET_SOSD) ? 8 : 0;
+        if (size < offset || (size - offset) % 8 != 0) {
+            fprintf(stderr, "Error: %s is not a %s file (size %jd)\n", name.c_str(), dataset_format_names[format], (intmax_t) size);
+            exit(EXIT_FAILURE);
+        }
+        uint64_t count = (size - offset) / 8;
+        if (format == DATASET_SOSD && (pread(fd, &count, 8, 0) != 8 || count > (uint64_t) (size - offset) / 8)) {
+            fprintf(stderr, "Error: %s has a bad SOSD key count\n", name.c_str());
+            exit(EXIT_FAILURE);
+        }
+        dataset_load_binary(&ds, fd, offset, count, format == DATASET_SOSD, tnum, key_range);
+    }
+    close(fd);
+    uint64_t t1 = exp_now_ns();
+    if (dataset_dedupe) {
+        parallel_sort_i64(tnum, ds.keys, ds.n);
+        int64_t distinct = std::unique(ds.keys, ds.keys + ds.n) - ds.keys;
+        ds.duplicates = ds.n - distinct;
+        ds.n = distinct;
+    }
+    if (dataset_shuffle) dataset_shuffle_keys(&ds, tnum);
+    uint64_t t2 = exp_now_ns();
+    std::cout << "dataset=" << name << " format=" << dataset_format_names[format] << " keys=" << ds.n
+              << " dropped_out_of_range=" << ds.dropped << " duplicates_removed=" << ds.duplicates
+              << " load_ms=" << (t1 - t0) / 1e6 << " prepare_ms=" << (t2 - t1) / 1e6 << std::endl;
+    if (ds.n == 0) {
+        fprintf(stderr, "Error: %s has no usable keys\n", name.c_str());
+        exit(EXIT_FAILURE);
+    }
+    return ds;
+}
+
+// the prefill, read and insert sets of -split. the prefill and insert sets are
+// slices of ds; the read set is allocated and must be freed with delete[].
+void dataset_split(const dataset & ds, int64_t ** prefill, int64_t * prefill_n,
+                   int64_t ** reads, int64_t * reads_n, int64_t ** inserts, int64_t * inserts_n) {
+    *prefill_n = (int64_t) (ds.n * dataset_split_fractions[0]);
+    *inserts_n = std::min((int64_t) (ds.n * dataset_split_fractions[2]), ds.n - *prefill_n);
+    *reads_n = std::min((int64_t) (ds.n * dataset_split_fractions[1]), *prefill_n);
+    *prefill = ds.keys;
+    *inserts = ds.keys + *prefill_n;
+    *reads = new int64_t[std::max(*reads_n, (int64_t) 1)];
+    for (int64_t i = 0; i < *reads_n; i++) (*reads)[i] = ds.keys[(int64_t) ((double) i * *prefill_n / *reads_n)];
+    std::cout << "split prefill=" << *prefill_n << " read=" << *reads_n << " insert=" << *inserts_n << std::endl;
+}
+
+void dataset_free(dataset * ds) {
+    delete[] ds->keys;
+    ds->keys = NULL;
+}
@@ -0,0 +1,188 @@
+/**
+ * Offline generator of operation streams for the benchmark driver.
+ *
+ * Writes the operations of a YCSB-style workload (see ycsb.h) in the
+ * `operation` binary format of pim_exp.hpp. Replaying the file with
+ * `bench_<ds> -opfile` keeps key generation out of the measured loop.
+ * The keys of the loaded records can also be written, as an i64 file for
+ * `bench_<ds> -file` to prefill the data structure with, e.g.,
+ *
+ *   gen_ops -ninit 10000000 -nops 20000000 -ycsb A -o a.ops -load a.keys
+ *   bench_brown_ext_abtree_lf.debra.new.none -file a.keys -opfile a.ops
+ */
+
+#include <iostream>
+#include <limits>
+#include <cstdio>
+#include <cstring>
+
+#include "pim_exp.hpp"
+#include "ycsb.h"
+
+using namespace std;
+
+// as in main.cpp
+const int64_t KEY_RANGE = std::numeric_limits<int64_t>::max() - 2;
+
+#define WRITE_BUFFER_SIZE 4096
+
+struct buffered_writer {
+    FILE * f;
+    size_t elem_size;
+    size_t count;
+    char buf[WRITE_BUFFER_SIZE * sizeof(operation)];
+};
+
+FILE * open_or_die(const char * path) {
+    FILE * f = fopen(path, "wb");
+    if (f == NULL) {
+        perror("Error opening file for writing");
+        exit(EXIT_FAILURE);
+    }
+    return f;
+}
+
+void writer_flush(buffered_writer * w) {
+    if (w->count > 0 && fwrite(w->buf, w->elem_size, w->count, w->f) != w->count) {
+        perror("Error writing file");
+        exit(EXIT_FAILURE);
+    }
+    w->count = 0;
+}
+
+void writer_put(buffered_writer * w, const void * elem) {
+    memcpy(w->buf + w->count * w->elem_size, elem, w->elem_size);
+    if (++w->count == WRITE_BUFFER_SIZE) writer_flush(w);
+}
+
+void print_usage(const char * prog) {
+    cout<<"usage: "<<prog<<" -o <path> [options]"<<endl;
+    cout<<"    -o <path>           write the operations here"<<endl;
+    cout<<"    -load <path>        also write the keys of the loaded records here (i64 file)"<<endl;
+    cout<<"    -ninit <int>        number of loaded records (default 1000000)"<<endl;
+    cout<<"    -nops <int>         number of operations (default ninit/5)"<<endl;
+    cout<<"    -seed <int>         random seed (default: time based)"<<endl;
+    cout<<"    -ycsb, -mix, -rw, -reqdist, -skew, -pim, -hot_phases, -hot_shift, -hot_skews, -scanlen, -scandist"<<endl;
+    cout<<"                        select the workload as for the benchmark driver"<<endl;
+}
+
+int main(int argc, char** argv) {
+
+    int64_t init_n = 1000000;
+    int64_t nops = -1;
+    double skewness = 0.99;
+    int pimNR = 2048;
+    int hot_phases = 100;
+    int64_t hot_shift = -1;
+    double hot_skews[MAX_HOTSPOT_SKEWS];
+    int hot_num_skews = 0;
+    int64_t seed = -1;
+    char * opfilename = NULL;
+    char * loadfilename = NULL;
+    int request_dist = -1;
+    int scan_dist = -1;
+
+    ycsb_set_workload("C");
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-o") == 0 && i+1 < argc) opfilename = argv[++i];
+        else if(strcmp(argv[i], "-load") == 0 && i+1 < argc) loadfilename = argv[++i];
+        else if(strcmp(argv[i], "-ninit") == 0 && i+1 < argc) init_n = atoll(argv[++i]);
+        else if(strcmp(argv[i], "-nops") == 0 && i+1 < argc) nops = atoll(argv[++i]);
+        else if(strcmp(argv[i], "-seed") == 0 && i+1 < argc) seed = atoll(argv[++i]);
+        else if(strcmp(argv[i], "-skew") == 0 && i+1 < argc) skewness = atof(argv[++i]);
+        else if(strcmp(argv[i], "-pim") == 0 && i+1 < argc) pimNR = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-hot_phases") == 0 && i+1 < argc) hot_phases = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-hot_shift") == 0 && i+1 < argc) hot_shift = atoll(argv[++i]);
+        else if(strcmp(argv[i], "-hot_skews") == 0 && i+1 < argc && (hot_num_skews = parse_hotspot_skews(argv[i+1], hot_skews)) > 0) i++;
+        else if(strcmp(argv[i], "-rw") == 0 && i+1 < argc) ycsb_set_rw(atof(argv[++i]));
+        else if(strcmp(argv[i], "-ycsb") == 0 && i+1 < argc && ycsb_set_workload(argv[i+1])) i++;
+        else if(strcmp(argv[i], "-mix") == 0 && i+1 < argc && ycsb_set_mix(argv[i+1])) i++;
+        else if(strcmp(argv[i], "-reqdist") == 0 && i+1 < argc && ycsb_parse_dist(argv[i+1], &request_dist)) i++;
+        else if(strcmp(argv[i], "-scandist") == 0 && i+1 < argc && ycsb_parse_dist(argv[i+1], &scan_dist)) i++;
+        else if(strcmp(argv[i], "-scanlen") == 0 && i+1 < argc) ycsb.max_scan_len = atoi(argv[++i]);
+        else {
+            if(strcmp(argv[i], "-help") != 0) cout<<"bad argument "<<argv[i]<<endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if(request_dist >= 0) ycsb.request_dist = request_dist;
+    if(scan_dist >= 0) ycsb.scan_dist = scan_dist;
+    if(opfilename == NULL || init_n < 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if(pimNR < 1 || pimNR > MAX_HOTSPOT_PARTITIONS) {
+        cout<<"-pim must be in [1, "<<MAX_HOTSPOT_PARTITIONS<<"]"<<endl;
+        return 1;
+    }
+    if(hot_phases < 1) {
+        cout<<"-hot_phases must be at least 1"<<endl;
+        return 1;
+    }
+    if(hot_num_skews == 0) hot_skews[hot_num_skews++] = skewness;
+    if(ycsb.scan_dist != YCSB_DIST_UNIFORM && ycsb.scan_dist != YCSB_DIST_ZIPFIAN) {
+        cout<<"-scandist must be uniform or zipfian"<<endl;
+        return 1;
+    }
+    if(ycsb.max_scan_len < 1) {
+        cout<<"-scanlen must be at least 1"<<endl;
+        return 1;
+    }
+    if(nops < 0) nops = init_n / 5;
+
+    if(seed < 0) seed = seed_and_print(0);
+    else rand_seed(seed, 0);
+    cout<<"seed="<<seed<<" ninit="<<init_n<<" nops="<<nops<<" skew="<<skewness<<endl;
+
+    ycsb_enabled = true;
+    ycsb_init(init_n, skewness, KEY_RANGE);
+    ycsb_print();
+
+    buffered_writer * w = new buffered_writer;
+
+    if(loadfilename != NULL) {
+        w->f = open_or_die(loadfilename);
+        w->elem_size = sizeof(int64_t);
+        w->count = 0;
+        for(int64_t i = 0; i < init_n; i++) {
+            int64_t key = ycsb_record_keys() ? ycsb_key(i) : rand_range(0, KEY_RANGE);
+            writer_put(w, &key);
+        }
+        writer_flush(w);
+        fclose(w->f);
+    }
+
+    w->f = open_or_die(opfilename);
+    w->elem_size = sizeof(operation);
+    w->count = 0;
+
+    // the hotspot moves hot_phases times over the stream, as in main.cpp
+    hotspot_distribution hot_dist;
+    rand_hotspot_init(&hot_dist, pimNR, KEY_RANGE, hot_phases, hot_shift, hot_skews, hot_num_skews);
+
+    operation o;
+    memset(&o, 0, sizeof(o));
+    for(int64_t i = 0; i < nops; i++) {
+        o.type = ycsb_next_op(0);
+        if(!ycsb_record_keys())
+            o.tsk.u.key = rand_hotspot(&hot_dist, i * hot_phases / nops, 0);
+        else if(o.type == insert_t)
+            o.tsk.u.key = ycsb_key(ycsb_new_record());
+        else
+            o.tsk.u.key = ycsb_key(ycsb_request_record(0));
+        // key (or lkey) first, value (or rkey) second, as replayed by main.cpp
+        if(o.type == update_t) o.tsk.u.value = o.tsk.u.key ^ (i << 1);
+        else if(o.type == scan_t) o.tsk.s.rkey = ycsb_scan_end(0, o.tsk.s.lkey);
+        else o.tsk.u.value = o.tsk.u.key;
+        writer_put(w, &o);
+    }
+    writer_flush(w);
+    fclose(w->f);
+
+    rand_hotspot_free(&hot_dist);
+    delete w;
+
+    return 0;
+}
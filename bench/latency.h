@@ -0,0 +1,151 @@
+#pragma once
+
+/**
+ * Low overhead per-thread operation latency recorder.
+ *
+ * Each operation is timed with a pair of rdtsc reads, and its latency (in TSC
+ * ticks) is recorded into a log-linear (HDR-style) histogram: values below
+ * 2^LAT_SUB_BITS ticks get one bucket each, and every power-of-two range above
+ * that is split into 2^LAT_SUB_BITS equal buckets, so a recorded value is
+ * reported with a relative error of at most 2^-LAT_SUB_BITS (about 3%).
+ *
+ * Every thread owns one histogram per operation type (see operation_t in
+ * pim_exp.hpp), so recording touches only thread-local memory. Histograms are
+ * merged when results are printed. Ticks are converted to nanoseconds using
+ * a TSC rate measured against CLOCK_MONOTONIC by lat_init_lib().
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <iostream>
+
+#include "tsc.h"
+#include "pim_exp.hpp"
+#include "thread_state.h"
+
+#define LAT_SUB_BITS 5
+#define LAT_SUB_COUNT (1 << LAT_SUB_BITS)
+#define LAT_MAX_BITS 40 // latencies of 2^40 ticks (several minutes) or more land in the last bucket
+#define LAT_NUM_BUCKETS ((LAT_MAX_BITS - LAT_SUB_BITS + 1) << LAT_SUB_BITS)
+
+struct lat_histogram {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[LAT_NUM_BUCKETS];
+};
+
+struct lat_thread_data {
+    lat_histogram hist[OPERATION_NR_ITEMS];
+};
+
+lat_thread_data * lat_data[MAX_THREADS_POW2] = {NULL};
+double lat_ticks_per_ns = 1.0;
+
+static inline int lat_bucket_index(uint64_t ticks) {
+    if (ticks < LAT_SUB_COUNT) return (int) ticks;
+    int shift = (63 - __builtin_clzll(ticks)) - LAT_SUB_BITS;
+    int ix = ((shift + 1) << LAT_SUB_BITS) + (int) ((ticks >> shift) - LAT_SUB_COUNT);
+    return (ix < LAT_NUM_BUCKETS) ? ix : LAT_NUM_BUCKETS - 1;
+}
+
+// midpoint of the range of values that map to bucket ix
+static inline uint64_t lat_bucket_value(int ix) {
+    if (ix < LAT_SUB_COUNT) return ix;
+    int shift = (ix >> LAT_SUB_BITS) - 1;
+    uint64_t sub = (ix & (LAT_SUB_COUNT - 1)) + LAT_SUB_COUNT;
+    return (sub << shift) + ((1ULL << shift) >> 1);
+}
+
+void lat_init_lib() {
+    timespec ts0, ts1, delay = {0, 50 * 1000 * 1000};
+    clock_gettime(CLOCK_MONOTONIC, &ts0);
+    uint64_t tsc0 = read_tsc();
+    nanosleep(&delay, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &ts1);
+    uint64_t tsc1 = read_tsc();
+    double ns = (ts1.tv_sec - ts0.tv_sec) * 1e9 + (ts1.tv_nsec - ts0.tv_nsec);
+    lat_ticks_per_ns = (tsc1 - tsc0) / ns;
+}
+
+// must be called by thread tid before it records anything in a new phase.
+// the thread allocates (first touch) and clears its own histograms.
+void lat_thread_init(int tid) {
+    thread_state_check(tid, "lat_thread_init");
+    if (lat_data[tid] == NULL) lat_data[tid] = (lat_thread_data *) thread_state_alloc(sizeof(lat_thread_data));
+    else memset(lat_data[tid], 0, sizeof(lat_thread_data));
+}
+
+static inline uint64_t lat_start() {
+    return read_tsc();
+}
+
+static inline void lat_stop(int tid, operation_t op, uint64_t start) {
+    uint64_t ticks = read_tsc() - start;
+    lat_histogram * h = &lat_data[tid]->hist[op];
+    ++h->count;
+    h->sum += ticks;
+    if (ticks > h->max) h->max = ticks;
+    ++h->buckets[lat_bucket_index(ticks)];
+}
+
+static uint64_t lat_percentile(lat_histogram * h, double pct) {
+    uint64_t rank = (uint64_t) (pct / 100.0 * h->count);
+    if (rank >= h->count) rank = h->count - 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < LAT_NUM_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen > rank) return std::min(lat_bucket_value(i), h->max);
+    }
+    return h->max;
+}
+
+static void lat_merge(lat_histogram * dest, lat_histogram * src) {
+    dest->count += src->count;
+    dest->sum += src->sum;
+    if (src->max > dest->max) dest->max = src->max;
+    for (int i = 0; i < LAT_NUM_BUCKETS; i++)
+        dest->buckets[i] += src->buckets[i];
+}
+
+static void lat_print_histogram(string label, lat_histogram * h) {
+    auto ns = [](double ticks) { return (uint64_t) (ticks / lat_ticks_per_ns); };
+    cout << label
+         << " count=" << h->count
+         << " avg_ns=" << ns((double) h->sum / h->count)
+         << " p50_ns=" << ns(lat_percentile(h, 50))
+         << " p90_ns=" << ns(lat_percentile(h, 90))
+         << " p99_ns=" << ns(lat_percentile(h, 99))
+         << " p99.9_ns=" << ns(lat_percentile(h, 99.9))
+         << " max_ns=" << ns(h->max) << endl;
+}
+
+// percentile pct of the latencies of all operation types and threads, in ns
+uint64_t lat_overall_percentile_ns(int threadNum, double pct) {
+    lat_histogram * merged = (lat_histogram *) calloc(1, sizeof(lat_histogram));
+    for (int op = 0; op < OPERATION_NR_ITEMS; op++)
+        for (int tid = 0; tid < threadNum; tid++)
+            if (lat_data[tid] != NULL) lat_merge(merged, &lat_data[tid]->hist[op]);
+    uint64_t result = (merged->count > 0) ? (uint64_t) (lat_percentile(merged, pct) / lat_ticks_per_ns) : 0;
+    free(merged);
+    return result;
+}
+
+// prints latency percentiles per operation type, merged over threads and per thread.
+void lat_print_summary(int threadNum) {
+    lat_histogram * merged = (lat_histogram *) calloc(1, sizeof(lat_histogram));
+    for (int op = 0; op < OPERATION_NR_ITEMS; op++) {
+        memset(merged, 0, sizeof(lat_histogram));
+        for (int tid = 0; tid < threadNum; tid++)
+            if (lat_data[tid] != NULL) lat_merge(merged, &lat_data[tid]->hist[op]);
+        if (merged->count == 0) continue;
+        lat_print_histogram(string("latency_") + operation_names[op], merged);
+        for (int tid = 0; tid < threadNum; tid++) {
+            if (lat_data[tid] == NULL || lat_data[tid]->hist[op].count == 0) continue;
+            lat_print_histogram(string("latency_") + operation_names[op] + "_tid" + to_string(tid), &lat_data[tid]->hist[op]);
+        }
+    }
+    free(merged);
+}
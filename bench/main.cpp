@@ -0,0 +1,1792 @@
+/**
+ * Generic benchmark driver for the data structures in ds/.
+ *
+ * The data structure (its ds_adapter), memory reclaimer, allocator and pool
+ * are selected at build time (see Makefile), so every data structure is
+ * driven by exactly the same harness code. All run parameters are taken
+ * from the command line (run with -help for a list).
+ *
+ * Based on the minimal_example.cpp files that used to live in each ds/ dir.
+ */
+
+#include <iostream>
+#include <limits>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+
+#include "adapter.h"
+
+#define __STR(x) #x
+#define STR(x) __STR(x)
+
+#include STR(RECLAIM_TYPE.h)
+#include STR(ALLOC_TYPE.h)
+#include STR(POOL_TYPE.h)
+
+#include "pim_exp.hpp"
+#include "papi_exp.h"
+#include "latency.h"
+#include "timed_run.h"
+#include "zipf.h"
+#include "ycsb.h"
+#include "sharded_adapter.h"
+#include "placement.h"
+#include "open_loop.h"
+#include "dataset.h"
+#include "string_keys.h"
+#include "mem_accountant.h"
+#include "churn.h"
+#include "sweep.h"
+
+using namespace std;
+
+#define DATA_STRUCTURE_ADAPTER_T ds_adapter<int64_t, void *, RECLAIM_TYPE<>, ALLOC_TYPE<>, POOL_TYPE<>>
+#define SHARDED_ADAPTER_T sharded_adapter<DATA_STRUCTURE_ADAPTER_T, int64_t, void *>
+
+// keys are drawn from [0, KEY_RANGE). the data structures reserve keys at
+// (or right below) the extremes of int64_t as sentinels.
+const int64_t KEY_MIN = std::numeric_limits<int64_t>::min();
+const int64_t KEY_MAX = std::numeric_limits<int64_t>::max();
+const int64_t KEY_RANGE = KEY_MAX - 2;
+
+// some adapters use NULL (and others (void *) -1) to mean "no value",
+// so we never store either of those.
+#define KEY_TO_VALUE(key) ((void *) (uintptr_t) ((key) | 1))
+
+int threadNum = 20;
+int pimNR = 2048;
+int numShards = 0;
+double skewness = 0.99;
+
+// schedule of the shifting hotspot that synthetic keys are drawn from
+int hot_phases = 100;
+double hot_period_ms = 0;
+int64_t hot_shift = -1;
+double hot_skews[MAX_HOTSPOT_SKEWS];
+int hot_num_skews = 0;
+
+rand_distribution uni_dist;
+hotspot_distribution hot_dist;
+
+// -record: every thread's operations of the YCSB phase, and with -record_ts
+// their issue times (in TSC ticks since the thread started the phase)
+const char * record_path = NULL;
+bool record_times = false;
+vector<operation> record_ops[MAX_THREADS_POW2];
+vector<uint64_t> record_ticks[MAX_THREADS_POW2];
+// and the keys each thread prefilled, written to <record_path>.keys
+vector<int64_t> record_prefill[MAX_THREADS_POW2];
+// -replay_timed: issue the operations of a recorded trace at their recorded times
+bool replay_timed = false;
+// -search pred: the search phase looks up the largest key <= each key instead of the key
+bool search_predecessor = false;
+// -batch: the prefill, search and insert phases pass their keys to insertBatch and
+// findBatch this many at a time (0: one operation per key)
+int op_batch = 0;
+
+// per-shard load is reported after each measured phase when the data structure is sharded
+template<class DATA_STRUCTURE_ADAPTER>
+void shard_stats_reset(DATA_STRUCTURE_ADAPTER *tree) {}
+template<class DATA_STRUCTURE_ADAPTER, typename K, typename V>
+void shard_stats_reset(sharded_adapter<DATA_STRUCTURE_ADAPTER, K, V> *tree) {
+    tree->resetShardStats();
+}
+
+template<class DATA_STRUCTURE_ADAPTER>
+void shard_stats_print(DATA_STRUCTURE_ADAPTER *tree) {}
+template<class DATA_STRUCTURE_ADAPTER, typename K, typename V>
+void shard_stats_print(sharded_adapter<DATA_STRUCTURE_ADAPTER, K, V> *tree) {
+    tree->printShardStats();
+    tree->resetShardStats();
+}
+
+// insertIfAbsent and erase, counting the keys they add and remove (see mem_accountant.h)
+template<class DATA_STRUCTURE_ADAPTER, typename K>
+static inline void * insert_counted(DATA_STRUCTURE_ADAPTER *tree, int tid, const K& key, void * val) {
+    void * old = tree->insertIfAbsent(tid, key, val);
+    if(old == tree->getNoValue()) mem_count_keys(tid, 1);
+    return old;
+}
+
+template<class DATA_STRUCTURE_ADAPTER, typename K>
+static inline void * erase_counted(DATA_STRUCTURE_ADAPTER *tree, int tid, const K& key) {
+    void * old = tree->erase(tid, key);
+    if(old != tree->getNoValue()) mem_count_keys(tid, -1);
+    return old;
+}
+
+// insertIfAbsent and find of n keys at once (-batch), counting the keys insertBatch adds
+template<class DATA_STRUCTURE_ADAPTER>
+static inline void insert_batch_counted(DATA_STRUCTURE_ADAPTER *tree, int tid, const int64_t * keys, void ** values, int n) {
+#ifdef DS_ADAPTER_SUPPORTS_BATCH
+    mem_count_keys(tid, tree->insertBatch(tid, keys, values, n));
+#else
+    setbench_error("insertBatch not implemented for this data structure");
+#endif
+}
+
+template<class DATA_STRUCTURE_ADAPTER>
+static inline void find_batch(DATA_STRUCTURE_ADAPTER *tree, int tid, const int64_t * keys, void ** values, int n) {
+#ifdef DS_ADAPTER_SUPPORTS_BATCH
+    tree->findBatch(tid, keys, n, values);
+#else
+    setbench_error("findBatch not implemented for this data structure");
+#endif
+}
+
+// the number of keys in the batch that starts at operation i of n: op_batch, but
+// without going past n when the phase runs a fixed number of operations
+static inline int batch_size(int64_t i, int64_t n) {
+    return (exp_duration_ms > 0 || n - i >= op_batch) ? op_batch : (int) (n - i);
+}
+
+// with -mem_stats, prints the memory footprint of the phase that just ended. built with
+// -DUSE_TREE_STATS, also the nodes reachable from the root, to check the live estimate.
+template<class DATA_STRUCTURE_ADAPTER>
+void mem_stats_print(DATA_STRUCTURE_ADAPTER *tree) {
+    mem_phase_print();
+#ifdef USE_TREE_STATS
+    if(!mem_stats_enabled) return;
+    auto ts = tree->createTreeStats(KEY_MIN, KEY_MAX);
+    cout<<"Memory_tree_stats: nodes="<<ts->getNodes()<<" keys="<<ts->getKeys()<<" mb="<<ts->getSizeInBytes() / (1024.0 * 1024)<<endl;
+    delete ts;
+#endif
+}
+template<class DATA_STRUCTURE_ADAPTER, typename K, typename V>
+void mem_stats_print(sharded_adapter<DATA_STRUCTURE_ADAPTER, K, V> *tree) {
+    mem_phase_print();
+}
+
+template<class DATA_STRUCTURE_ADAPTER>
+struct i64_wrapper {
+    int tid;
+    DATA_STRUCTURE_ADAPTER *tree;
+    int64_t n;
+    int64_t* ops;
+};
+
+template<class DATA_STRUCTURE_ADAPTER>
+void* init_per_thread_i64(void *ptr) {
+
+    i64_wrapper<DATA_STRUCTURE_ADAPTER> *input_wrapper = (i64_wrapper<DATA_STRUCTURE_ADAPTER>*) ptr;
+
+    int tid = input_wrapper->tid;
+    auto tree = input_wrapper->tree;
+    int64_t n = input_wrapper->n;
+    int64_t* ops = input_wrapper->ops;
+
+    placement_bind_thread(tid);
+    tree->initThread(tid);
+
+    int64_t key;
+
+    // with -batch, keys are collected and inserted op_batch at a time
+    vector<int64_t> batch_keys;
+    vector<void *> batch_values;
+    auto insert = [&](int64_t key) {
+        if(op_batch <= 0) {
+            insert_counted(tree, tid, key, KEY_TO_VALUE(key));
+            return;
+        }
+        batch_keys.push_back(key);
+        batch_values.push_back(KEY_TO_VALUE(key));
+        if((int) batch_keys.size() == op_batch) {
+            insert_batch_counted(tree, tid, batch_keys.data(), batch_values.data(), op_batch);
+            batch_keys.clear();
+            batch_values.clear();
+        }
+    };
+
+    if(ops != NULL) {
+        for(int64_t i = 0; i < n; i++) {
+            key = ops[i];
+            insert(key);
+        }
+    }
+    else if(ycsb_record_keys()) {
+        for(int64_t i = 0; i < n; i++) {
+            key = ycsb_key(n * tid + i);
+            insert(key);
+            if(record_path != NULL) record_prefill[tid].push_back(key);
+        }
+    }
+    else {
+        for(int64_t i = 0; i < n; i++) {
+            key = rand_dist(&uni_dist, tid);
+            insert(key);
+            if(record_path != NULL) record_prefill[tid].push_back(key);
+        }
+    }
+    if(!batch_keys.empty()) insert_batch_counted(tree, tid, batch_keys.data(), batch_values.data(), (int) batch_keys.size());
+
+    tree->deinitThread(tid);
+
+    return NULL;
+}
+
+template<class DATA_STRUCTURE_ADAPTER>
+bool run_init_threads_i64(const int tnum, DATA_STRUCTURE_ADAPTER *tree, i64_array init_ops) {
+
+    int64_t init_n = init_ops.n;
+    int64_t* ops =  init_ops.i64_map;
+    int64_t n_per_thread = init_n / tnum;
+
+    pthread_t threads[tnum];
+    i64_wrapper<DATA_STRUCTURE_ADAPTER> input_wrappers[tnum];
+
+    int result;
+
+    if(ops == NULL) rand_uniform_init(&uni_dist, KEY_RANGE);
+
+    for(int i=0; i<tnum; i++) {
+        input_wrappers[i].tid = i;
+        input_wrappers[i].tree = tree;
+        if(ops == NULL) {
+            seed_and_print(i);
+            input_wrappers[i].ops = NULL;
+        }
+        else
+            input_wrappers[i].ops = &(ops[n_per_thread * i]);
+        input_wrappers[i].n = (ops != NULL && i == tnum - 1) ? init_n - n_per_thread * i : n_per_thread;
+
+        result = pthread_create(&(threads[i]), NULL, init_per_thread_i64<DATA_STRUCTURE_ADAPTER>, &(input_wrappers[i]));
+        if (result != 0) {
+            printf("Thread creation error\n");
+            return false;
+        }
+    }
+    for (int i = 0; i < tnum; i++) {
+        result = pthread_join(threads[i], NULL);
+        if (result != 0) {
+            printf("Thread join error\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+// prefills the data structure with the same keys as run_init_threads_i64, but
+// sorts and deduplicates them first, and builds the data structure bottom-up
+// with its bulkLoad, with leaves and internal nodes filled to fill * capacity.
+template<class DATA_STRUCTURE_ADAPTER>
+bool run_bulk_load_i64(const int tnum, DATA_STRUCTURE_ADAPTER *tree, i64_array init_ops, double fill) {
+#ifdef DS_ADAPTER_SUPPORTS_BULK_LOAD
+    int64_t init_n = init_ops.n;
+    int64_t* ops = init_ops.i64_map;
+    int64_t n_per_thread = init_n / tnum;
+    int64_t n = (ops != NULL) ? init_n : n_per_thread * tnum;
+
+    uint64_t t0 = exp_now_ns();
+
+    int64_t * keys = new int64_t[n];
+    void ** values = new void *[n];
+    if(ops == NULL && !ycsb_record_keys()) rand_uniform_init(&uni_dist, KEY_RANGE);
+    vector<thread> threads;
+    for(int tid = 0; tid < tnum; tid++) {
+        threads.emplace_back([=]() {
+            int64_t begin = n_per_thread * tid;
+            int64_t end = (tid == tnum - 1) ? n : begin + n_per_thread;
+            if(ops != NULL) memcpy(keys + begin, ops + begin, (end - begin) * sizeof(int64_t));
+            else if(ycsb_record_keys()) for(int64_t i = begin; i < end; i++) keys[i] = ycsb_key(i);
+            else {
+                seed_and_print(tid);
+                for(int64_t i = begin; i < end; i++) keys[i] = rand_dist(&uni_dist, tid);
+            }
+        });
+    }
+    for(auto & t : threads) t.join();
+
+    parallel_sort_i64(tnum, keys, n);
+    n = std::unique(keys, keys + n) - keys;
+
+    threads.clear();
+    for(int tid = 0; tid < tnum; tid++) {
+        threads.emplace_back([=]() {
+            for(int64_t i = n * tid / tnum; i < n * (tid + 1) / tnum; i++) values[i] = KEY_TO_VALUE(keys[i]);
+        });
+    }
+    for(auto & t : threads) t.join();
+
+    uint64_t t1 = exp_now_ns();
+    tree->bulkLoad(tnum, keys, values, n, fill);
+    mem_count_keys(0, n);
+    uint64_t t2 = exp_now_ns();
+
+    cout<<"Bulk load: "<<n<<" distinct keys, prepared_ms="<<(t1 - t0) / 1e6<<" built_ms="<<(t2 - t1) / 1e6<<endl;
+    if(record_path != NULL && ops == NULL) record_prefill[0].assign(keys, keys + n);
+
+    delete[] keys;
+    delete[] values;
+    return true;
+#else
+    return false;
+#endif
+}
+
+// the largest key <= key (the latest entry at or before a time)
+template<class DATA_STRUCTURE_ADAPTER, typename K>
+static inline void run_predecessor(DATA_STRUCTURE_ADAPTER *tree, int tid, const K& key) {
+#ifdef DS_ADAPTER_SUPPORTS_ORDERED_SEARCH
+    K found;
+    tree->predecessor(tid, key, &found);
+#else
+    setbench_error("predecessor not implemented for this data structure");
+#endif
+}
+
+template<class DATA_STRUCTURE_ADAPTER>
+void* search_per_thread_i64(void *ptr) {
+
+    i64_wrapper<DATA_STRUCTURE_ADAPTER> *input_wrapper = (i64_wrapper<DATA_STRUCTURE_ADAPTER>*) ptr;
+
+    int tid = input_wrapper->tid;
+    auto tree = input_wrapper->tree;
+    int64_t n = input_wrapper->n;
+    int64_t* ops = input_wrapper->ops;
+
+    int64_t key;
+
+    uint64_t t0;
+
+    int papi_event = papi_exp_start_counter(tid);
+
+    placement_bind_thread(tid);
+    tree->initThread(tid);
+    lat_thread_init(tid);
+    exp_thread_ready(tid);
+    openloop_thread_start(tid);
+
+    if(op_batch > 0) {
+        // one latency sample per batch
+        vector<int64_t> keys(op_batch);
+        vector<void *> values(op_batch);
+        for(int64_t i = 0; exp_keep_running(i, n); i += op_batch) {
+            int b = batch_size(i, n);
+            for(int j = 0; j < b; j++) keys[j] = (ops == NULL) ? rand_hotspot(&hot_dist, exp_batch_index(i + j, n), tid) : ops[(i + j) % n];
+            t0 = lat_start();
+            find_batch(tree, tid, keys.data(), values.data(), b);
+            lat_stop(tid, get_t, t0);
+            exp_count_ops(tid, b);
+        }
+    }
+    else if(ops == NULL) {
+        for(int64_t i = 0; exp_keep_running(i, n); i++) {
+            key = rand_hotspot(&hot_dist, exp_batch_index(i, n), tid);
+            if(!openloop_send_time(tid, &t0)) break;
+            if(search_predecessor) run_predecessor(tree, tid, key);
+            else tree->find(tid, key);
+            lat_stop(tid, search_predecessor ? predecessor_t : get_t, t0);
+            exp_count_op(tid);
+        }
+    }
+    else {
+        for(int64_t i = 0; exp_keep_running(i, n); i++) {
+            key = ops[i % n];
+            if(!openloop_send_time(tid, &t0)) break;
+            if(search_predecessor) run_predecessor(tree, tid, key);
+            else tree->find(tid, key);
+            lat_stop(tid, search_predecessor ? predecessor_t : get_t, t0);
+            exp_count_op(tid);
+        }
+    }
+
+    exp_thread_done(tid);
+    openloop_thread_done(tid);
+
+    tree->deinitThread(tid);
+
+    papi_exp_stop_counter(tid, papi_event);
+
+    return NULL;
+}
+
+template<class DATA_STRUCTURE_ADAPTER>
+void* insert_per_thread_i64(void *ptr) {
+
+    i64_wrapper<DATA_STRUCTURE_ADAPTER> *input_wrapper = (i64_wrapper<DATA_STRUCTURE_ADAPTER>*) ptr;
+
+    int tid = input_wrapper->tid;
+    auto tree = input_wrapper->tree;
+    int64_t n = input_wrapper->n;
+    int64_t* ops = input_wrapper->ops;
+
+    int64_t key;
+
+    uint64_t t0;
+
+    int papi_event = papi_exp_start_counter(tid);
+
+    placement_bind_thread(tid);
+    tree->initThread(tid);
+    lat_thread_init(tid);
+    exp_thread_ready(tid);
+    openloop_thread_start(tid);
+
+    if(op_batch > 0) {
+        // one latency sample per batch
+        vector<int64_t> keys(op_batch);
+        vector<void *> values(op_batch);
+        for(int64_t i = 0; exp_keep_running(i, n); i += op_batch) {
+            int b = batch_size(i, n);
+            for(int j = 0; j < b; j++) {
+                keys[j] = (ops == NULL) ? rand_hotspot(&hot_dist, exp_batch_index(i + j, n), tid) : ops[(i + j) % n];
+                values[j] = KEY_TO_VALUE(keys[j]);
+            }
+            t0 = lat_start();
+            insert_batch_counted(tree, tid, keys.data(), values.data(), b);
+            lat_stop(tid, insert_t, t0);
+            exp_count_ops(tid, b);
+        }
+    }
+    else if(ops == NULL) {
+        for(int64_t i = 0; exp_keep_running(i, n); i++) {
+            key = rand_hotspot(&hot_dist, exp_batch_index(i, n), tid);
+            if(!openloop_send_time(tid, &t0)) break;
+            insert_counted(tree, tid, key, KEY_TO_VALUE(key));
+            lat_stop(tid, insert_t, t0);
+            exp_count_op(tid);
+        }
+    }
+    else {
+        for(int64_t i = 0; exp_keep_running(i, n); i++) {
+            key = ops[i % n];
+            if(!openloop_send_time(tid, &t0)) break;
+            insert_counted(tree, tid, key, KEY_TO_VALUE(key));
+            lat_stop(tid, insert_t, t0);
+            exp_count_op(tid);
+        }
+    }
+
+    exp_thread_done(tid);
+    openloop_thread_done(tid);
+
+    tree->deinitThread(tid);
+
+    papi_exp_stop_counter(tid, papi_event);
+
+    return NULL;
+}
+
+template<class DATA_STRUCTURE_ADAPTER>
+bool run_test_threads_i64(const int tnum, DATA_STRUCTURE_ADAPTER *tree, i64_array test_ops, operation_t op_type) {
+
+    int64_t init_n = test_ops.n;
+    int64_t* ops =  test_ops.i64_map;
+    int64_t n_per_thread = init_n / tnum;
+
+    pthread_t threads[tnum];
+    i64_wrapper<DATA_STRUCTURE_ADAPTER> input_wrappers[tnum];
+
+    int result;
+
+    exp_phase_reset(hot_dist.num_phases);
+
+    for(int i=0; i<tnum; i++) {
+        input_wrappers[i].tid = i;
+        input_wrappers[i].tree = tree;
+        if(ops == NULL) {
+            input_wrappers[i].ops = NULL;
+            seed_and_print(i);
+        }
+        else
+            input_wrappers[i].ops = &(ops[n_per_thread * i]);
+        input_wrappers[i].n = n_per_thread;
+
+        if(op_type == operation_t::predecessor_t)
+            result = pthread_create(&(threads[i]), NULL, search_per_thread_i64<DATA_STRUCTURE_ADAPTER>, &(input_wrappers[i]));
+        else if(op_type == operation_t::insert_t)
+            result = pthread_create(&(threads[i]), NULL, insert_per_thread_i64<DATA_STRUCTURE_ADAPTER>, &(input_wrappers[i]));
+        else return false;
+
+        if (result != 0) {
+            printf("Thread creation error\n");
+            return false;
+        }
+    }
+    exp_phase_run(tnum);
+    for (int i = 0; i < tnum; i++) {
+        result = pthread_join(threads[i], NULL);
+        if (result != 0) {
+            printf("Thread join error\n");
+            return false;
+        }
+    }
+    papi_exp_print_counters(exp_phase_ops(tnum), tnum);
+    exp_phase_print(tnum);
+    mem_stats_print(tree);
+    openloop_print(tnum);
+    lat_print_summary(tnum);
+    shard_stats_print(tree);
+    sweep_phase_done(op_type == operation_t::insert_t ? "insert" : "search", tnum);
+    return true;
+}
+
+template<class DATA_STRUCTURE_ADAPTER>
+struct ycsb_wrapper {
+    int tid;
+    DATA_STRUCTURE_ADAPTER *tree;
+    int64_t n;
+};
+
+// an update replaces the value of key. data structures without insert-replace
+// get an erase followed by an insert, which is not atomic.
+template<class DATA_STRUCTURE_ADAPTER, typename K>
+static inline void ycsb_update(DATA_STRUCTURE_ADAPTER *tree, int tid, const K& key, void * val) {
+#ifdef DS_ADAPTER_SUPPORTS_INSERT_REPLACE
+    if(tree->insert(tid, key, val) == tree->getNoValue()) mem_count_keys(tid, 1);
+#else
+    erase_counted(tree, tid, key);
+    insert_counted(tree, tid, key, val);
+#endif
+}
+
+// executes one operation. arg is the new value of update and insert, and the
+// last key of scan. a scan returns at most scan_capacity records, the size of
+// the scan_keys and scan_values buffers.
+template<class DATA_STRUCTURE_ADAPTER>
+static inline void run_op(DATA_STRUCTURE_ADAPTER *tree, int tid, operation_t op, int64_t key, int64_t arg,
+                          int64_t * scan_keys, void ** scan_values, int scan_capacity) {
+    void * val;
+    switch(op) {
+        case get_t:
+            tree->find(tid, key);
+            break;
+        case update_t:
+            ycsb_update(tree, tid, key, KEY_TO_VALUE(arg));
+            break;
+        case predecessor_t:
+            run_predecessor(tree, tid, key);
+            break;
+        case scan_t:
+            tree->rangeQuery(tid, key, arg, scan_keys, scan_values, scan_capacity);
+            break;
+        case insert_t:
+            insert_counted(tree, tid, key, KEY_TO_VALUE(arg));
+            break;
+        case remove_t:
+            erase_counted(tree, tid, key);
+            break;
+        case rmw_t:
+            val = tree->find(tid, key);
+            val = (val == tree->getNoValue()) ? KEY_TO_VALUE(key) : KEY_TO_VALUE(((uintptr_t) val + 2) & KEY_MAX);
+            ycsb_update(tree, tid, key, val);
+            break;
+        default:
+            setbench_error("operation type not supported by the benchmark");
+    }
+}
+
+template<class DATA_STRUCTURE_ADAPTER>
+void* ycsb_per_thread_i64(void *ptr) {
+
+    ycsb_wrapper<DATA_STRUCTURE_ADAPTER> *input_wrapper = (ycsb_wrapper<DATA_STRUCTURE_ADAPTER>*) ptr;
+
+    int tid = input_wrapper->tid;
+    auto tree = input_wrapper->tree;
+    int64_t n = input_wrapper->n;
+
+    int64_t key, arg;
+    operation_t op;
+    int64_t * scan_keys = new int64_t[ycsb.max_scan_len];
+    void ** scan_values = new void *[ycsb.max_scan_len];
+
+    uint64_t t0, phase_start;
+
+    vector<operation> * rec = (record_path != NULL) ? &record_ops[tid] : NULL;
+    vector<uint64_t> * rec_ticks = (rec != NULL && record_times) ? &record_ticks[tid] : NULL;
+    if(rec != NULL && exp_duration_ms <= 0) rec->reserve(n);
+    if(rec_ticks != NULL && exp_duration_ms <= 0) rec_ticks->reserve(n);
+
+    int papi_event = papi_exp_start_counter(tid);
+
+    placement_bind_thread(tid);
+    tree->initThread(tid);
+    lat_thread_init(tid);
+    exp_thread_ready(tid);
+    openloop_thread_start(tid);
+    phase_start = read_tsc();
+
+    for(int64_t i = 0; exp_keep_running(i, n); i++) {
+        op = ycsb_next_op(tid);
+        if(!ycsb_record_keys())
+            key = rand_hotspot(&hot_dist, exp_batch_index(i, n), tid);
+        else if(op == insert_t)
+            key = ycsb_key(ycsb_new_record());
+        else
+            key = ycsb_key(ycsb_request_record(tid));
+        if(op == update_t) arg = key ^ (i << 1);
+        else if(op == scan_t) arg = ycsb_scan_end(tid, key);
+        else arg = key;
+        if(!openloop_send_time(tid, &t0)) break;
+        run_op(tree, tid, op, key, arg, scan_keys, scan_values, ycsb.max_scan_len);
+        lat_stop(tid, op, t0);
+        exp_count_op(tid);
+        if(rec != NULL) {
+            operation o;
+            memset(&o, 0, sizeof(o));
+            o.type = op;
+            o.tsk.u.key = key;
+            o.tsk.u.value = arg;
+            rec->push_back(o);
+            if(rec_ticks != NULL) rec_ticks->push_back(t0 - phase_start);
+        }
+    }
+
+    exp_thread_done(tid);
+    openloop_thread_done(tid);
+
+    tree->deinitThread(tid);
+
+    papi_exp_stop_counter(tid, papi_event);
+
+    delete[] scan_keys;
+    delete[] scan_values;
+
+    return NULL;
+}
+
+template<class DATA_STRUCTURE_ADAPTER>
+bool run_ycsb_threads_i64(const int tnum, DATA_STRUCTURE_ADAPTER *tree, int64_t init_n) {
+
+    int64_t n_per_thread = init_n / tnum;
+
+    pthread_t threads[tnum];
+    ycsb_wrapper<DATA_STRUCTURE_ADAPTER> input_wrappers[tnum];
+
+    int result;
+
+    exp_phase_reset(hot_dist.num_phases);
+
+    for(int i=0; i<tnum; i++) {
+        input_wrappers[i].tid = i;
+        input_wrappers[i].tree = tree;
+        seed_and_print(i);
+        input_wrappers[i].n = n_per_thread;
+        record_ops[i].clear();
+        record_ticks[i].clear();
+
+        result = pthread_create(&(threads[i]), NULL, ycsb_per_thread_i64<DATA_STRUCTURE_ADAPTER>, &(input_wrappers[i]));
+        if (result != 0) {
+            printf("Thread creation error\n");
+            return false;
+        }
+    }
+    exp_phase_run(tnum);
+    for (int i = 0; i < tnum; i++) {
+        result = pthread_join(threads[i], NULL);
+        if (result != 0) {
+            printf("Thread join error\n");
+            return false;
+        }
+    }
+    papi_exp_print_counters(exp_phase_ops(tnum), tnum);
+    exp_phase_print(tnum);
+    mem_stats_print(tree);
+    openloop_print(tnum);
+    lat_print_summary(tnum);
+    shard_stats_print(tree);
+    sweep_phase_done("ycsb", tnum);
+
+    if(record_path != NULL) {
+        int64_t recorded = 0;
+        for(int i = 0; i < tnum; i++) {
+            recorded += record_ops[i].size();
+            for(auto & t : record_ticks[i]) t = (uint64_t) (t / lat_ticks_per_ns);
+        }
+        write_trace_file(string(record_path), tnum, record_ops, record_times ? record_ticks : NULL);
+        cout<<"Recorded trace: "<<record_path<<" nthreads="<<tnum<<" ops="<<recorded<<" timestamps="<<record_times<<endl;
+        for(int i = 0; i < tnum; i++) {
+            vector<operation>().swap(record_ops[i]);
+            vector<uint64_t>().swap(record_ticks[i]);
+        }
+    }
+    return true;
+}
+
+template<class DATA_STRUCTURE_ADAPTER>
+struct churn_wrapper {
+    int tid;
+    DATA_STRUCTURE_ADAPTER *tree;
+    int64_t n;
+    int64_t *slots;     // the churn_keys slots owned by the thread
+    int64_t nslots;
+};
+
+// fills the thread's slots with distinct random keys of the churn range
+template<class DATA_STRUCTURE_ADAPTER>
+void* churn_init_per_thread(void *ptr) {
+
+    churn_wrapper<DATA_STRUCTURE_ADAPTER> *input_wrapper = (churn_wrapper<DATA_STRUCTURE_ADAPTER>*) ptr;
+
+    int tid = input_wrapper->tid;
+    auto tree = input_wrapper->tree;
+
+    placement_bind_thread(tid);
+    tree->initThread(tid);
+
+    int64_t key;
+    for(int64_t i = 0; i < input_wrapper->nslots; i++) {
+        do key = churn_random_key(tid);
+        while(insert_counted(tree, tid, key, KEY_TO_VALUE(key)) != tree->getNoValue());
+        input_wrapper->slots[i] = key;
+    }
+
+    tree->deinitThread(tid);
+
+    return NULL;
+}
+
+template<class DATA_STRUCTURE_ADAPTER>
+bool run_churn_init_threads(const int tnum, DATA_STRUCTURE_ADAPTER *tree) {
+
+    pthread_t threads[tnum];
+    churn_wrapper<DATA_STRUCTURE_ADAPTER> input_wrappers[tnum];
+
+    int result;
+
+    for(int i=0; i<tnum; i++) {
+        input_wrappers[i].tid = i;
+        input_wrappers[i].tree = tree;
+        seed_and_print(i);
+        input_wrappers[i].slots = &churn_keys[churn_slot_begin(i, tnum)];
+        input_wrappers[i].nslots = churn_slot_begin(i + 1, tnum) - churn_slot_begin(i, tnum);
+
+        result = pthread_create(&(threads[i]), NULL, churn_init_per_thread<DATA_STRUCTURE_ADAPTER>, &(input_wrappers[i]));
+        if (result != 0) {
+            printf("Thread creation error\n");
+            return false;
+        }
+    }
+    for (int i = 0; i < tnum; i++) {
+        result = pthread_join(threads[i], NULL);
+        if (result != 0) {
+            printf("Thread join error\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+// an update inserts a fresh key and erases the key of one of the thread's
+// slots (both timed from their send time), anything else is a get (see churn.h)
+template<class DATA_STRUCTURE_ADAPTER>
+void* churn_per_thread_i64(void *ptr) {
+
+    churn_wrapper<DATA_STRUCTURE_ADAPTER> *input_wrapper = (churn_wrapper<DATA_STRUCTURE_ADAPTER>*) ptr;
+
+    int tid = input_wrapper->tid;
+    auto tree = input_wrapper->tree;
+    int64_t n = input_wrapper->n;
+    int64_t *slots = input_wrapper->slots;
+    int64_t nslots = input_wrapper->nslots;
+
+    int64_t key;
+    uint64_t t0;
+
+    int papi_event = papi_exp_start_counter(tid);
+
+    placement_bind_thread(tid);
+    tree->initThread(tid);
+    lat_thread_init(tid);
+    exp_thread_ready(tid);
+    openloop_thread_start(tid);
+
+    for(int64_t i = 0; exp_keep_running(i, n); i++) {
+        if(nslots > 0 && rand_double(tid) < churn_update) {
+            int64_t *slot = &slots[rand_range(tid, nslots)];
+            if(!openloop_send_time(tid, &t0)) break;
+            do key = churn_random_key(tid);
+            while(insert_counted(tree, tid, key, KEY_TO_VALUE(key)) != tree->getNoValue());
+            lat_stop(tid, insert_t, t0);
+            exp_count_op(tid);
+            // the erase runs even if the phase ended before it was due, to keep the
+            // size constant, but it is then neither recorded nor counted
+            bool due = openloop_send_time(tid, &t0);
+            erase_counted(tree, tid, *slot);
+            *slot = key;
+            if(!due) break;
+            lat_stop(tid, remove_t, t0);
+            exp_count_op(tid);
+        }
+        else {
+            key = churn_random_key(tid);
+            if(!openloop_send_time(tid, &t0)) break;
+            tree->find(tid, key);
+            lat_stop(tid, get_t, t0);
+            exp_count_op(tid);
+        }
+    }
+
+    exp_thread_done(tid);
+    openloop_thread_done(tid);
+
+    tree->deinitThread(tid);
+
+    papi_exp_stop_counter(tid, papi_event);
+
+    return NULL;
+}
+
+template<class DATA_STRUCTURE_ADAPTER>
+bool run_churn_threads_i64(const int tnum, DATA_STRUCTURE_ADAPTER *tree, int64_t test_n) {
+
+    pthread_t threads[tnum];
+    churn_wrapper<DATA_STRUCTURE_ADAPTER> input_wrappers[tnum];
+
+    int result;
+
+    exp_phase_reset(1);
+    mem_phase_begin();
+
+    for(int i=0; i<tnum; i++) {
+        input_wrappers[i].tid = i;
+        input_wrappers[i].tree = tree;
+        seed_and_print(i);
+        input_wrappers[i].n = test_n / tnum;
+        input_wrappers[i].slots = &churn_keys[churn_slot_begin(i, tnum)];
+        input_wrappers[i].nslots = churn_slot_begin(i + 1, tnum) - churn_slot_begin(i, tnum);
+
+        result = pthread_create(&(threads[i]), NULL, churn_per_thread_i64<DATA_STRUCTURE_ADAPTER>, &(input_wrappers[i]));
+        if (result != 0) {
+            printf("Thread creation error\n");
+            return false;
+        }
+    }
+    exp_phase_run(tnum);
+    for (int i = 0; i < tnum; i++) {
+        result = pthread_join(threads[i], NULL);
+        if (result != 0) {
+            printf("Thread join error\n");
+            return false;
+        }
+    }
+    papi_exp_print_counters(exp_phase_ops(tnum), tnum);
+    exp_phase_print(tnum);
+    mem_stats_print(tree);
+    churn_phase_print(tnum);
+    openloop_print(tnum);
+    lat_print_summary(tnum);
+    shard_stats_print(tree);
+    sweep_phase_done("churn", tnum);
+    return true;
+}
+
+// finds the highest open-loop rate at which the p99 latency over all operations
+// stays within slo_us, by bisection over timed YCSB phases on the same data
+// structure. the search starts from max_rate, or from the closed-loop
+// throughput if max_rate is 0. a rate is sustained if its p99 meets the SLO
+// and at least 95% of the offered operations completed.
+template<class DATA_STRUCTURE_ADAPTER>
+double run_slo_search(const int tnum, DATA_STRUCTURE_ADAPTER *tree, int64_t test_n, double slo_us, double max_rate, int steps) {
+    double lo = 0, hi = max_rate;
+    if(hi <= 0) {
+        openloop_set_rate(0, tnum);
+        run_ycsb_threads_i64(tnum, tree, test_n);
+        hi = exp_phase_throughput(tnum);
+        cout<<"slo_closed_loop_throughput="<<hi<<endl;
+    }
+    for(int step = 0; step <= steps; step++) {
+        double rate = (step == 0) ? hi : (lo + hi) / 2;
+        openloop_set_rate(rate, tnum);
+        run_ycsb_threads_i64(tnum, tree, test_n);
+        double achieved = exp_phase_throughput(tnum);
+        double p99_us = lat_overall_percentile_ns(tnum, 99) / 1000.0;
+        bool ok = p99_us <= slo_us && achieved >= 0.95 * rate;
+        cout<<"slo_step="<<step<<" offered="<<rate<<" achieved="<<achieved<<" p99_us="<<p99_us<<" ok="<<ok<<endl;
+        if(ok) lo = rate;
+        else hi = rate;
+        if(step == 0 && ok) break;
+    }
+    openloop_set_rate(0, tnum);
+    cout<<"Max_sustainable_rate: "<<lo<<" slo_p99_us="<<slo_us<<endl;
+    return lo;
+}
+
+#ifdef DS_ADAPTER_SUPPORTS_STRING_KEYS
+#define STR_DATA_STRUCTURE_ADAPTER_T ds_adapter<str_key, void *, RECLAIM_TYPE<>, ALLOC_TYPE<>, POOL_TYPE<>>
+
+// with -keys, record r of the YCSB engine has the string key str_keys.keys[r]
+str_key_arena str_keys;
+
+template<class DATA_STRUCTURE_ADAPTER>
+void* str_init_per_thread(void *ptr) {
+
+    ycsb_wrapper<DATA_STRUCTURE_ADAPTER> *input_wrapper = (ycsb_wrapper<DATA_STRUCTURE_ADAPTER>*) ptr;
+
+    int tid = input_wrapper->tid;
+    auto tree = input_wrapper->tree;
+    int64_t n = input_wrapper->n;
+
+    placement_bind_thread(tid);
+    tree->initThread(tid);
+
+    for(int64_t r = n * tid; r < n * (tid + 1); r++)
+        insert_counted(tree, tid, str_keys.keys[r], KEY_TO_VALUE(r));
+
+    tree->deinitThread(tid);
+
+    return NULL;
+}
+
+// ycsb_per_thread_i64 on string keys. the arena holds the loaded records and
+// room for nops inserts; records past its end (in a long timed phase) wrap
+// around to the keys of existing records.
+template<class DATA_STRUCTURE_ADAPTER>
+void* str_ycsb_per_thread(void *ptr) {
+
+    ycsb_wrapper<DATA_STRUCTURE_ADAPTER> *input_wrapper = (ycsb_wrapper<DATA_STRUCTURE_ADAPTER>*) ptr;
+
+    int tid = input_wrapper->tid;
+    auto tree = input_wrapper->tree;
+    int64_t n = input_wrapper->n;
+
+    int64_t record;
+    operation_t op;
+    void * val;
+
+    uint64_t t0;
+
+    int papi_event = papi_exp_start_counter(tid);
+
+    placement_bind_thread(tid);
+    tree->initThread(tid);
+    lat_thread_init(tid);
+    exp_thread_ready(tid);
+    openloop_thread_start(tid);
+
+    for(int64_t i = 0; exp_keep_running(i, n); i++) {
+        op = ycsb_next_op(tid);
+        record = (op == insert_t) ? ycsb_new_record() : ycsb_request_record(tid);
+        const str_key & key = str_keys.keys[record % str_keys.n];
+        if(!openloop_send_time(tid, &t0)) break;
+        switch(op) {
+            case get_t:
+                tree->find(tid, key);
+                break;
+            case predecessor_t:
+                run_predecessor(tree, tid, key);
+                break;
+            case update_t:
+                ycsb_update(tree, tid, key, KEY_TO_VALUE(record ^ (i << 1)));
+                break;
+            case insert_t:
+                insert_counted(tree, tid, key, KEY_TO_VALUE(record));
+                break;
+            case remove_t:
+                erase_counted(tree, tid, key);
+                break;
+            case rmw_t:
+                val = tree->find(tid, key);
+                val = (val == tree->getNoValue()) ? KEY_TO_VALUE(record) : KEY_TO_VALUE(((uintptr_t) val + 2) & KEY_MAX);
+                ycsb_update(tree, tid, key, val);
+                break;
+            default:
+                setbench_error("operation type not supported with string keys");
+        }
+        lat_stop(tid, op, t0);
+        exp_count_op(tid);
+    }
+
+    exp_thread_done(tid);
+    openloop_thread_done(tid);
+
+    tree->deinitThread(tid);
+
+    papi_exp_stop_counter(tid, papi_event);
+
+    return NULL;
+}
+
+// runs tnum threads of fn with n records or operations each; measured phases are timed
+template<class DATA_STRUCTURE_ADAPTER>
+bool run_str_threads(const int tnum, DATA_STRUCTURE_ADAPTER *tree, int64_t n, void* (*fn)(void *), bool measured) {
+
+    pthread_t threads[tnum];
+    ycsb_wrapper<DATA_STRUCTURE_ADAPTER> input_wrappers[tnum];
+
+    int result;
+
+    if(measured) exp_phase_reset(1);
+
+    for(int i=0; i<tnum; i++) {
+        input_wrappers[i].tid = i;
+        input_wrappers[i].tree = tree;
+        input_wrappers[i].n = n;
+        seed_and_print(i);
+
+        result = pthread_create(&(threads[i]), NULL, fn, &(input_wrappers[i]));
+        if (result != 0) {
+            printf("Thread creation error\n");
+            return false;
+        }
+    }
+    if(measured) exp_phase_run(tnum);
+    for (int i = 0; i < tnum; i++) {
+        result = pthread_join(threads[i], NULL);
+        if (result != 0) {
+            printf("Thread join error\n");
+            return false;
+        }
+    }
+    if(measured) {
+        papi_exp_print_counters(exp_phase_ops(tnum), tnum);
+        exp_phase_print(tnum);
+        mem_phase_print();
+        openloop_print(tnum);
+        lat_print_summary(tnum);
+        sweep_phase_done("ycsb", tnum);
+    }
+    return true;
+}
+
+// run_experiment for -keys: loads the YCSB records under their string keys,
+// then runs the single YCSB phase
+template<class DATA_STRUCTURE_ADAPTER>
+void run_string_experiment(DATA_STRUCTURE_ADAPTER *tree, int64_t init_n, int64_t test_n) {
+
+    int64_t n_per_thread = init_n / threadNum;
+    ycsb_init(n_per_thread * threadNum, skewness, KEY_RANGE);
+    ycsb_print();
+    str_key_arena_build(&str_keys, n_per_thread * threadNum + test_n, threadNum);
+    str_key_arena_print(&str_keys);
+
+    mem_attach(tree);
+    placement_prefill_begin(threadNum);
+    run_str_threads(threadNum, tree, n_per_thread, str_init_per_thread<DATA_STRUCTURE_ADAPTER>, false);
+    placement_prefill_end();
+    cout<<"Init finished"<<endl;
+    placement_print_node_memory("prefill");
+
+    papi_exp_init_lib();
+    lat_init_lib();
+
+    int built_threads = threadNum;
+    double rate = openloop_rate;
+    for(int tnum : sweep_phase_threads(built_threads)) {
+        threadNum = tnum;
+        openloop_set_rate(rate, tnum);
+        if(sweep_spec != NULL) cout<<"sweep_nthreads="<<tnum<<endl;
+
+        cout<<"nops="<<test_n<<endl;
+        run_str_threads(threadNum, tree, test_n / threadNum, str_ycsb_per_thread<DATA_STRUCTURE_ADAPTER>, true);
+        cout<<"YCSB test finished."<<endl;
+
+        placement_print_binding(threadNum);
+    }
+    threadNum = built_threads;
+    openloop_set_rate(rate, threadNum);
+
+    placement_print_node_memory("final");
+
+    str_key_arena_free(&str_keys);
+}
+#endif
+
+template<class DATA_STRUCTURE_ADAPTER>
+struct replay_wrapper {
+    int tid;
+    DATA_STRUCTURE_ADAPTER *tree;
+    int64_t n;
+    operation* ops;         // this thread's operations, or NULL to stream them
+    int64_t begin;          // from entry begin of the file
+    trace_stream stream;
+    bool timed;             // issue each operation at its recorded time
+    const uint64_t* times;  // recorded issue times in ns, or NULL to stream them
+    int64_t times_begin;    // from uint64_t entry times_begin of the file
+    trace_stream times_stream;
+};
+
+// recorded issue time (ns since the start of the phase) of operation i of a timed replay thread
+template<class DATA_STRUCTURE_ADAPTER>
+static inline uint64_t replay_time(replay_wrapper<DATA_STRUCTURE_ADAPTER> *w, int64_t i) {
+    if(w->times != NULL) return w->times[i];
+    return *(const uint64_t *) trace_stream_get(&(w->times_stream), w->times_begin + i);
+}
+
+// an operation file only records the key interval of a scan, so replayed scans
+// return at most this many records, whatever -scanlen the file was written with
+#define REPLAY_SCAN_CAPACITY 65536
+
+template<class DATA_STRUCTURE_ADAPTER>
+void* replay_per_thread(void *ptr) {
+
+    replay_wrapper<DATA_STRUCTURE_ADAPTER> *input_wrapper = (replay_wrapper<DATA_STRUCTURE_ADAPTER>*) ptr;
+
+    int tid = input_wrapper->tid;
+    auto tree = input_wrapper->tree;
+    int64_t n = input_wrapper->n;
+    operation* ops = input_wrapper->ops;
+    int64_t begin = input_wrapper->begin;
+
+    const operation * o;
+    int64_t * scan_keys = new int64_t[REPLAY_SCAN_CAPACITY];
+    void ** scan_values = new void *[REPLAY_SCAN_CAPACITY];
+
+    uint64_t t0, phase_start;
+
+    // a timed replay that runs out of operations before the end of a timed
+    // phase starts over right after the last recorded time
+    uint64_t period = (input_wrapper->timed && n > 0) ? replay_time(input_wrapper, n - 1) + 1 : 0;
+
+    int papi_event = papi_exp_start_counter(tid);
+
+    placement_bind_thread(tid);
+    tree->initThread(tid);
+    lat_thread_init(tid);
+    exp_thread_ready(tid);
+    openloop_thread_start(tid);
+    phase_start = read_tsc();
+
+    for(int64_t i = 0; n > 0 && exp_keep_running(i, n); i++) {
+        if(ops != NULL) o = &(ops[i % n]);
+        else o = (const operation *) trace_stream_get(&(input_wrapper->stream), begin + i % n);
+        // every operation keeps its key (or lkey) first, and its value (or rkey) second
+        if(input_wrapper->timed) {
+            // like the open loop, latency is measured from the recorded issue time
+            t0 = phase_start + (uint64_t) (((i / n) * period + replay_time(input_wrapper, i % n)) * lat_ticks_per_ns);
+            while(read_tsc() < t0 && !exp_stop) {}
+            if(read_tsc() < t0) break;  // the phase ended before the operation was due
+        }
+        else if(!openloop_send_time(tid, &t0)) break;
+        run_op(tree, tid, o->type, o->tsk.u.key, o->tsk.u.value, scan_keys, scan_values, REPLAY_SCAN_CAPACITY);
+        lat_stop(tid, o->type, t0);
+        exp_count_op(tid);
+    }
+
+    exp_thread_done(tid);
+    openloop_thread_done(tid);
+
+    tree->deinitThread(tid);
+
+    papi_exp_stop_counter(tid, papi_event);
+
+    delete[] scan_keys;
+    delete[] scan_values;
+
+    return NULL;
+}
+
+// replays an operation file: thread i executes the i'th of tnum equal slices of it,
+// or, for a recorded trace (see write_trace_file), the operations recorded by thread i.
+// with stream_chunk > 0, only stream_chunk operations per thread are mapped at a time.
+template<class DATA_STRUCTURE_ADAPTER>
+bool run_replay_threads(const int tnum, DATA_STRUCTURE_ADAPTER *tree, const char * filename, int64_t stream_chunk) {
+
+    bool recorded = is_trace_file(string(filename));
+    trace_layout layout;
+    char * trace_map = NULL;
+    int64_t trace_bytes = 0;
+    ops_array file_ops;
+    if(recorded) {
+        layout = read_trace_layout(string(filename));
+        if(stream_chunk <= 0) trace_map = (char *) map_trace_file(string(filename), 1, &trace_bytes, true);
+        file_ops.n = 0;
+        file_ops.operation_map = NULL;
+    }
+    else if(stream_chunk > 0) {
+        file_ops.n = trace_file_entries(string(filename), sizeof(operation));
+        file_ops.operation_map = NULL;
+    }
+    else file_ops = read_op_file(string(filename));
+
+    int64_t n_per_thread = file_ops.n / tnum;
+
+    pthread_t threads[tnum];
+    replay_wrapper<DATA_STRUCTURE_ADAPTER> input_wrappers[tnum];
+
+    int result;
+
+    exp_phase_reset(1);
+
+    for(int i=0; i<tnum; i++) {
+        input_wrappers[i].tid = i;
+        input_wrappers[i].tree = tree;
+        input_wrappers[i].n = recorded ? layout.counts[i] : n_per_thread;
+        input_wrappers[i].begin = recorded ? layout.op_begin[i] : n_per_thread * i;
+        input_wrappers[i].timed = replay_timed;
+        input_wrappers[i].times = NULL;
+        input_wrappers[i].times_begin = recorded ? layout.ts_begin[i] : 0;
+        if(recorded && stream_chunk > 0) {
+            input_wrappers[i].ops = NULL;
+            trace_stream_open(&(input_wrappers[i].stream), string(filename), sizeof(operation),
+                              layout.op_begin[i], layout.op_begin[i] + layout.counts[i], stream_chunk);
+            if(replay_timed)
+                trace_stream_open(&(input_wrappers[i].times_stream), string(filename), sizeof(uint64_t),
+                                  layout.ts_begin[i], layout.ts_begin[i] + layout.counts[i], stream_chunk);
+        }
+        else if(recorded) {
+            input_wrappers[i].ops = (operation *) trace_map + layout.op_begin[i];
+            if(replay_timed) input_wrappers[i].times = (const uint64_t *) trace_map + layout.ts_begin[i];
+        }
+        else if(stream_chunk > 0) {
+            input_wrappers[i].ops = NULL;
+            trace_stream_open(&(input_wrappers[i].stream), string(filename), sizeof(operation),
+                              n_per_thread * i, n_per_thread * (i + 1), stream_chunk);
+        }
+        else
+            input_wrappers[i].ops = &(file_ops.operation_map[n_per_thread * i]);
+
+        result = pthread_create(&(threads[i]), NULL, replay_per_thread<DATA_STRUCTURE_ADAPTER>, &(input_wrappers[i]));
+        if (result != 0) {
+            printf("Thread creation error\n");
+            return false;
+        }
+    }
+    exp_phase_run(tnum);
+    for (int i = 0; i < tnum; i++) {
+        result = pthread_join(threads[i], NULL);
+        if (result != 0) {
+            printf("Thread join error\n");
+            return false;
+        }
+        if(stream_chunk > 0) trace_stream_close(&(input_wrappers[i].stream));
+        if(stream_chunk > 0 && input_wrappers[i].timed) trace_stream_close(&(input_wrappers[i].times_stream));
+    }
+    papi_exp_print_counters(exp_phase_ops(tnum), tnum);
+    exp_phase_print(tnum);
+    mem_stats_print(tree);
+    openloop_print(tnum);
+    lat_print_summary(tnum);
+    shard_stats_print(tree);
+    sweep_phase_done("replay", tnum);
+
+    if(trace_map != NULL) munmap(trace_map, trace_bytes);
+    else if(stream_chunk <= 0) munmap(file_ops.operation_map, file_ops.n * sizeof(operation));
+    return true;
+}
+
+// prefills tree and runs the measured phases selected on the command line
+template<class DATA_STRUCTURE_ADAPTER>
+void run_experiment(DATA_STRUCTURE_ADAPTER *tree, int64_t init_n, int64_t test_n, const char * filename,
+                    const char * opfilename, int64_t stream_chunk, double bulk_fill, double slo_us, int slo_steps) {
+
+    i64_array init_ops, search_ops, insert_ops;
+    dataset ds;
+    int64_t * read_keys = NULL;
+
+    if(filename != NULL && dataset_split_fractions[0] > 0) {
+        ds = dataset_load(string(filename), threadNum, KEY_RANGE);
+        dataset_split(ds, &init_ops.i64_map, &init_ops.n, &read_keys, &search_ops.n, &insert_ops.i64_map, &insert_ops.n);
+        search_ops.i64_map = read_keys;
+        test_n = search_ops.n;
+    }
+    else if(filename != NULL) {
+        // the first 5/6 (all with an opfile) are prefilled, and the searches and inserts use the last 1/6
+        ds = dataset_load(string(filename), threadNum, KEY_RANGE);
+        init_n = (opfilename != NULL) ? ds.n : ds.n * 5 / 6;
+        test_n = ds.n / 6;
+        init_ops.i64_map = ds.keys;
+        init_ops.n = init_n;
+        search_ops.i64_map = &(ds.keys[ds.n - test_n]);
+        insert_ops.i64_map = search_ops.i64_map;
+        search_ops.n = test_n;
+        insert_ops.n = test_n;
+    }
+    else {
+        init_ops.i64_map = NULL;
+        init_ops.n = init_n;
+        search_ops.i64_map = NULL;
+        insert_ops.i64_map = NULL;
+        search_ops.n = test_n;
+        insert_ops.n = test_n;
+    }
+
+    if(ycsb_enabled) {
+        ycsb_init(init_ops.n / threadNum * threadNum, skewness, KEY_RANGE);
+        ycsb_print();
+    }
+
+    if(churn_enabled()) {
+        churn_init(init_n);
+        churn_print();
+    }
+    mem_attach(tree);
+    placement_prefill_begin(threadNum);
+    if(churn_enabled()) run_churn_init_threads(threadNum, tree);
+    else if(bulk_fill > 0) run_bulk_load_i64(threadNum, tree, init_ops, bulk_fill);
+    else run_init_threads_i64(threadNum, tree, init_ops);
+    placement_prefill_end();
+    cout<<"Init finished"<<endl;
+    if(record_path != NULL && filename == NULL) {
+        // a replay prefills from this file (-file <path>.keys) to start from the same keys
+        int64_t recorded = 0;
+        for(int i = 0; i < threadNum; i++) recorded += record_prefill[i].size();
+        write_i64_file(string(record_path) + ".keys", record_prefill, threadNum);
+        cout<<"Recorded prefill: "<<record_path<<".keys keys="<<recorded<<endl;
+        for(int i = 0; i < threadNum; i++) vector<int64_t>().swap(record_prefill[i]);
+    }
+    placement_print_node_memory("prefill");
+    shard_stats_reset(tree);
+
+    papi_exp_init_lib();
+    lat_init_lib();
+
+    // with -sweep, the same phases for every thread count
+    int built_threads = threadNum;
+    double rate = openloop_rate;
+    for(int tnum : sweep_phase_threads(built_threads)) {
+        threadNum = tnum;
+        openloop_set_rate(rate, tnum);
+        if(sweep_spec != NULL) cout<<"sweep_nthreads="<<tnum<<endl;
+
+        if(opfilename != NULL) {
+            cout<<"opfile="<<opfilename<<" stream="<<stream_chunk<<endl;
+            run_replay_threads(threadNum, tree, opfilename, stream_chunk);
+            cout<<"Replay test finished."<<endl;
+        }
+        else if(slo_us > 0) {
+            cout<<"nops="<<test_n<<" slo_p99_us="<<slo_us<<" slo_steps="<<slo_steps<<endl;
+            run_slo_search(threadNum, tree, test_n, slo_us, rate, slo_steps);
+            cout<<"SLO search finished."<<endl;
+        }
+        else if(ycsb_enabled) {
+            cout<<"nops="<<test_n<<endl;
+            run_ycsb_threads_i64(threadNum, tree, test_n);
+            cout<<"YCSB test finished."<<endl;
+        }
+        else if(churn_enabled()) {
+            cout<<"nops="<<test_n<<endl;
+            run_churn_threads_i64(threadNum, tree, test_n);
+            cout<<"Churn test finished."<<endl;
+        }
+        else {
+            cout<<search_ops.n<<" "<<search_ops.i64_map<<endl;
+            run_test_threads_i64(threadNum, tree, search_ops, operation_t::predecessor_t);
+            cout<<"Search test finished."<<endl;
+
+            cout<<insert_ops.n<<" "<<insert_ops.i64_map<<endl;
+            run_test_threads_i64(threadNum, tree, insert_ops, operation_t::insert_t);
+            cout<<"Insert test finished."<<endl;
+        }
+
+        placement_print_binding(threadNum);
+    }
+    threadNum = built_threads;
+    openloop_set_rate(rate, threadNum);
+
+    placement_print_node_memory("final");
+
+    if(filename != NULL) {
+        dataset_free(&ds);
+        delete[] read_keys;
+    }
+    if(churn_enabled()) churn_free();
+}
+
+void print_usage(const char * prog) {
+    cout<<"usage: "<<prog<<" [options]"<<endl;
+    cout<<"    -nthreads <int>     number of worker threads (default 20)"<<endl;
+    cout<<"    -ninit <int>        number of uniform random keys to prefill (synthetic mode)"<<endl;
+    cout<<"    -nops <int>         operations per measured phase (default ninit/5)"<<endl;
+    cout<<"    -skew <double>      zipf skewness of the measured key distribution (default 0.99)"<<endl;
+    cout<<"    -pim <int>          number of PIM partitions modeled by the key generator (default 2048)"<<endl;
+    cout<<"    -bind <policy>      pin threads: compact (fill a NUMA node, cores before SMT siblings),"<<endl;
+    cout<<"                        scatter (round-robin over nodes) or a CPU list like 0-7,16-23"<<endl;
+    cout<<"    -prefill_mem <p>    place the prefilled data structure: interleave (over all NUMA nodes)"<<endl;
+    cout<<"                        or local (over the nodes of the -bind CPUs used by the threads)"<<endl;
+    cout<<"    -shards <int>       split the key range over this many independent instances of the data"<<endl;
+    cout<<"                        structure, and report per-shard load (e.g. the -pim value; default 0: one)"<<endl;
+    cout<<"    -hot_phases <int>   the hot partitions change this many times per measured phase (default 100)"<<endl;
+    cout<<"    -hot_period <double> or every this many milliseconds (with -duration)"<<endl;
+    cout<<"    -hot_shift <int>    move the hot set by this many partitions per hotspot phase"<<endl;
+    cout<<"                        (default -1: pick an unrelated hot set every time)"<<endl;
+    cout<<"    -hot_skews <list>   comma separated skews used by consecutive hotspot phases (default -skew)"<<endl;
+    cout<<"    -search <get|pred>  the search phase finds its keys (get, default) or looks up the largest"<<endl;
+    cout<<"                        key <= each of them (pred)"<<endl;
+    cout<<"    -rw <double>        run a single mixed phase with this find ratio (the rest are inserts)"<<endl;
+    cout<<"                        instead of the separate search and insert phases"<<endl;
+    cout<<"    -ycsb <A-F>         run a single phase of YCSB core workload A, B, C, D, E or F instead"<<endl;
+    cout<<"    -mix <op=frac,...>  run a single phase with this operation mix instead, e.g. get=0.9,remove=0.1"<<endl;
+    cout<<"                        (ops: get, update, predecessor, scan, insert, remove, rmw)"<<endl;
+    cout<<"    -churn <double>     run a single phase that keeps the size constant: this fraction of the"<<endl;
+    cout<<"                        operations replace a live key by a new one (insert, then erase), the"<<endl;
+    cout<<"                        rest are gets; reports reclamation, limbo and memory growth"<<endl;
+    cout<<"    -churn_range <double> -churn draws keys from this many times -ninit keys (default 2)"<<endl;
+    cout<<"    -reqdist <dist>     request distribution of -ycsb/-mix: uniform, zipfian, latest or pim"<<endl;
+    cout<<"    -scanlen <int>      maximum scan length (default 100)"<<endl;
+    cout<<"    -scandist <dist>    scan length distribution: uniform (default) or zipfian"<<endl;
+    cout<<"    -duration <double>  run each measured phase for this many seconds instead of a fixed"<<endl;
+    cout<<"                        number of operations (-nops is then ignored)"<<endl;
+    cout<<"    -interval <int>     sample aggregate throughput every this many milliseconds (default 100)"<<endl;
+    cout<<"    -rate <double>      open loop: issue operations at this aggregate rate (Mops/s) on a fixed"<<endl;
+    cout<<"                        schedule, and measure latency from the scheduled send time"<<endl;
+    cout<<"    -arrival <a>        open loop send times: poisson (default) or constant"<<endl;
+    cout<<"    -slo_p99 <double>   find the highest open loop rate with p99 latency within this many"<<endl;
+    cout<<"                        microseconds (needs -duration and -ycsb, -mix or -rw; -rate bounds it)"<<endl;
+    cout<<"    -slo_steps <int>    bisection steps of the -slo_p99 search (default 8)"<<endl;
+    cout<<"    -papi_events <list> comma separated PAPI events to count per thread (default: $PAPI_EVENTS,"<<endl;
+    cout<<"                        else "<<PAPI_DEFAULT_EVENTS<<"); multiplexed if there are"<<endl;
+    cout<<"                        more than hardware counters"<<endl;
+    cout<<"    -file <path>        prefill from a dataset instead; the first 5/6 of it are inserted and"<<endl;
+    cout<<"                        the last 1/6 drive the search and insert phases (with -opfile, all"<<endl;
+    cout<<"                        of it is inserted)"<<endl;
+    cout<<"    -format <f>         dataset format: sosd (uint64 count, then keys), i64 (raw int64 keys),"<<endl;
+    cout<<"                        text (a key per line) or auto (default: detected from the file)"<<endl;
+    cout<<"    -dedupe             remove duplicate keys from the dataset (sorts it)"<<endl;
+    cout<<"    -shuffle            shuffle the dataset (after -dedupe; use -seed to repeat the order)"<<endl;
+    cout<<"    -split <p,r,i>      prefill the first fraction p of the dataset, insert the next fraction i,"<<endl;
+    cout<<"                        and search a sample of r (of all keys) of the prefilled keys"<<endl;
+    cout<<"    -bulkload <double>  prefill by sorting the keys and building the data structure bottom-up,"<<endl;
+    cout<<"                        with nodes filled to this fraction of their capacity (e.g. 1 or 0.7)"<<endl;
+    cout<<"    -batch <int>        prefill, search and insert this many keys at a time with insertBatch and"<<endl;
+    cout<<"                        findBatch (latencies are per batch)"<<endl;
+    cout<<"    -opfile <path>      run a single phase that replays this operation file (see gen_ops)"<<endl;
+    cout<<"                        (scans return at most "<<REPLAY_SCAN_CAPACITY<<" records)"<<endl;
+    cout<<"    -stream <int>       map only this many operations per thread of -opfile at a time"<<endl;
+    cout<<"                        (default 0: map and prefault the whole file before the phase)"<<endl;
+    cout<<"    -keys <format>      run -ycsb or -mix on string keys: url (URL strings) or composite"<<endl;
+    cout<<"                        (16 byte binary composite IDs), with data structures that support them"<<endl;
+    cout<<"    -seed <int>         derive all random seeds from this one instead of the clock"<<endl;
+    cout<<"    -record <path>      write the operations of each thread of the -ycsb, -mix or -rw phase"<<endl;
+    cout<<"                        to this trace file, which -opfile replays thread by thread, and the"<<endl;
+    cout<<"                        prefilled keys to <path>.keys, for -file"<<endl;
+    cout<<"    -record_ts          also record when each operation was issued"<<endl;
+    cout<<"    -replay_timed       replay a trace recorded with -record_ts at its recorded issue times"<<endl;
+    cout<<"    -mem_stats          sample the memory footprint per key (live nodes, nodes in limbo and"<<endl;
+    cout<<"                        allocator overhead) with every throughput sample"<<endl;
+    cout<<"    -sweep <spec>       run the measured phases at 1, 2, 4, ... and N threads (N or max: all"<<endl;
+    cout<<"                        CPUs), or at the thread counts of a list, e.g. 1,8,24-26"<<endl;
+    cout<<"    -sweep_smt          also at the physical core count of each NUMA node (binds compact"<<endl;
+    cout<<"                        without -bind)"<<endl;
+    cout<<"    -sweep_rebuild      build and prefill a new data structure for every thread count"<<endl;
+    cout<<"                        (default: prefill once, with the most threads)"<<endl;
+    cout<<"    -results <path>     write a row per measured phase (throughput, latency percentiles,"<<endl;
+    cout<<"                        counters per operation): CSV, or JSON lines for .json or .jsonl"<<endl;
+}
+
+int main(int argc, char** argv) {
+
+    int64_t init_n = 1000000;
+    int64_t test_n = -1;
+    char * filename = NULL;
+    char * opfilename = NULL;
+    int64_t stream_chunk = 0;
+    double bulk_fill = 0;
+    double rate = 0;
+    double slo_us = 0;
+    int slo_steps = 8;
+    int request_dist = -1;
+    int scan_dist = -1;
+
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-nthreads") == 0 && i+1 < argc) threadNum = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-ninit") == 0 && i+1 < argc) init_n = atoll(argv[++i]);
+        else if(strcmp(argv[i], "-nops") == 0 && i+1 < argc) test_n = atoll(argv[++i]);
+        else if(strcmp(argv[i], "-skew") == 0 && i+1 < argc) skewness = atof(argv[++i]);
+        else if(strcmp(argv[i], "-pim") == 0 && i+1 < argc) pimNR = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-bind") == 0 && i+1 < argc && placement_set_policy(argv[i+1])) i++;
+        else if(strcmp(argv[i], "-prefill_mem") == 0 && i+1 < argc && placement_set_prefill_mem(argv[i+1])) i++;
+        else if(strcmp(argv[i], "-shards") == 0 && i+1 < argc) numShards = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-hot_phases") == 0 && i+1 < argc) hot_phases = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-hot_period") == 0 && i+1 < argc) hot_period_ms = atof(argv[++i]);
+        else if(strcmp(argv[i], "-hot_shift") == 0 && i+1 < argc) hot_shift = atoll(argv[++i]);
+        else if(strcmp(argv[i], "-hot_skews") == 0 && i+1 < argc && (hot_num_skews = parse_hotspot_skews(argv[i+1], hot_skews)) > 0) i++;
+        else if(strcmp(argv[i], "-rw") == 0 && i+1 < argc) {
+            ycsb_set_rw(atof(argv[++i]));
+            ycsb_enabled = true;
+        }
+        else if(strcmp(argv[i], "-ycsb") == 0 && i+1 < argc && ycsb_set_workload(argv[i+1])) {
+            ycsb_enabled = true;
+            i++;
+        }
+        else if(strcmp(argv[i], "-mix") == 0 && i+1 < argc && ycsb_set_mix(argv[i+1])) {
+            ycsb_enabled = true;
+            i++;
+        }
+        else if(strcmp(argv[i], "-search") == 0 && i+1 < argc && (strcmp(argv[i+1], "get") == 0 || strcmp(argv[i+1], "pred") == 0))
+            search_predecessor = (strcmp(argv[++i], "pred") == 0);
+        else if(strcmp(argv[i], "-reqdist") == 0 && i+1 < argc && ycsb_parse_dist(argv[i+1], &request_dist)) i++;
+        else if(strcmp(argv[i], "-scandist") == 0 && i+1 < argc && ycsb_parse_dist(argv[i+1], &scan_dist)) i++;
+        else if(strcmp(argv[i], "-scanlen") == 0 && i+1 < argc) ycsb.max_scan_len = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-duration") == 0 && i+1 < argc) exp_duration_ms = atof(argv[++i]) * 1000;
+        else if(strcmp(argv[i], "-interval") == 0 && i+1 < argc) exp_interval_ms = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-rate") == 0 && i+1 < argc) rate = atof(argv[++i]);
+        else if(strcmp(argv[i], "-arrival") == 0 && i+1 < argc && openloop_parse_arrival(argv[i+1])) i++;
+        else if(strcmp(argv[i], "-slo_p99") == 0 && i+1 < argc) slo_us = atof(argv[++i]);
+        else if(strcmp(argv[i], "-slo_steps") == 0 && i+1 < argc) slo_steps = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-papi_events") == 0 && i+1 < argc && papi_exp_set_events(argv[i+1])) i++;
+        else if(strcmp(argv[i], "-file") == 0 && i+1 < argc) filename = argv[++i];
+        else if(strcmp(argv[i], "-format") == 0 && i+1 < argc && dataset_parse_format(argv[i+1])) i++;
+        else if(strcmp(argv[i], "-dedupe") == 0) dataset_dedupe = true;
+        else if(strcmp(argv[i], "-shuffle") == 0) dataset_shuffle = true;
+        else if(strcmp(argv[i], "-split") == 0 && i+1 < argc && dataset_parse_split(argv[i+1])) i++;
+        else if(strcmp(argv[i], "-bulkload") == 0 && i+1 < argc) bulk_fill = atof(argv[++i]);
+        else if(strcmp(argv[i], "-batch") == 0 && i+1 < argc) op_batch = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-opfile") == 0 && i+1 < argc) opfilename = argv[++i];
+        else if(strcmp(argv[i], "-stream") == 0 && i+1 < argc) stream_chunk = atoll(argv[++i]);
+        else if(strcmp(argv[i], "-keys") == 0 && i+1 < argc && str_key_parse_format(argv[i+1])) i++;
+        else if(strcmp(argv[i], "-seed") == 0 && i+1 < argc) rand_base_seed = atoll(argv[++i]);
+        else if(strcmp(argv[i], "-record") == 0 && i+1 < argc) record_path = argv[++i];
+        else if(strcmp(argv[i], "-record_ts") == 0) record_times = true;
+        else if(strcmp(argv[i], "-replay_timed") == 0) replay_timed = true;
+        else if(strcmp(argv[i], "-mem_stats") == 0) mem_stats_enabled = true;
+        else if(strcmp(argv[i], "-churn") == 0 && i+1 < argc) churn_update = atof(argv[++i]);
+        else if(strcmp(argv[i], "-churn_range") == 0 && i+1 < argc) churn_range_factor = atof(argv[++i]);
+        else if(strcmp(argv[i], "-sweep") == 0 && i+1 < argc) sweep_spec = argv[++i];
+        else if(strcmp(argv[i], "-sweep_smt") == 0) sweep_smt = true;
+        else if(strcmp(argv[i], "-sweep_rebuild") == 0) sweep_rebuild = true;
+        else if(strcmp(argv[i], "-results") == 0 && i+1 < argc) results_path = argv[++i];
+        else {
+            if(strcmp(argv[i], "-help") != 0) cout<<"bad argument "<<argv[i]<<endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if(threadNum < 1 || threadNum > MAX_THREADS_POW2) {
+        cout<<"-nthreads must be in [1, "<<MAX_THREADS_POW2<<"] (MAX_THREADS_POW2 in the Makefile)"<<endl;
+        return 1;
+    }
+    if((sweep_smt || sweep_rebuild) && sweep_spec == NULL) {
+        cout<<"-sweep_smt and -sweep_rebuild need -sweep"<<endl;
+        return 1;
+    }
+    if(sweep_smt && placement_policy == "none") placement_set_policy("compact");
+    if(!sweep_init(threadNum, MAX_THREADS_POW2)) {
+        cout<<"-sweep must be a thread count, max or a list of thread counts in [1, "<<MAX_THREADS_POW2<<"]"<<endl;
+        return 1;
+    }
+    // the data structure is built for the most threads of the sweep
+    threadNum = sweep_threads.back();
+    if(sweep_spec != NULL && (record_path != NULL || (opfilename != NULL && is_trace_file(string(opfilename))))) {
+        cout<<"-sweep cannot be combined with -record or the replay of a recorded trace"<<endl;
+        return 1;
+    }
+    if(pimNR < 1 || pimNR > MAX_HOTSPOT_PARTITIONS) {
+        cout<<"-pim must be in [1, "<<MAX_HOTSPOT_PARTITIONS<<"]"<<endl;
+        return 1;
+    }
+    if(placement_prefill_mem == PLACEMENT_PREFILL_LOCAL && placement_policy == "none") {
+        cout<<"-prefill_mem local needs -bind"<<endl;
+        return 1;
+    }
+#ifndef USE_LIBNUMA
+    if(placement_prefill_mem != PLACEMENT_PREFILL_DEFAULT) {
+        cout<<"-prefill_mem needs libnuma (see Makefile)"<<endl;
+        return 1;
+    }
+#endif
+    if(rate < 0) {
+        cout<<"-rate must be positive"<<endl;
+        return 1;
+    }
+    if(slo_us > 0 && (exp_duration_ms <= 0 || !ycsb_enabled || opfilename != NULL || slo_steps < 0)) {
+        cout<<"-slo_p99 needs -duration and -ycsb, -mix or -rw, and -slo_steps >= 0"<<endl;
+        return 1;
+    }
+    openloop_set_rate(rate, threadNum);
+    if(numShards < 0 || numShards > MAX_HOTSPOT_PARTITIONS) {
+        cout<<"-shards must be in [0, "<<MAX_HOTSPOT_PARTITIONS<<"]"<<endl;
+        return 1;
+    }
+    if(hot_period_ms > 0) {
+        if(exp_duration_ms <= 0) {
+            cout<<"-hot_period needs -duration"<<endl;
+            return 1;
+        }
+        hot_phases = (int) ceil(exp_duration_ms / hot_period_ms);
+    }
+    if(hot_phases < 1) {
+        cout<<"-hot_phases must be at least 1"<<endl;
+        return 1;
+    }
+    if(hot_num_skews == 0) hot_skews[hot_num_skews++] = skewness;
+    if(exp_interval_ms < 1) {
+        cout<<"-interval must be at least 1"<<endl;
+        return 1;
+    }
+    // the distributions override those of -ycsb and -rw, wherever they appear
+    if(request_dist >= 0) ycsb.request_dist = request_dist;
+    if(scan_dist >= 0) ycsb.scan_dist = scan_dist;
+    if(ycsb.scan_dist != YCSB_DIST_UNIFORM && ycsb.scan_dist != YCSB_DIST_ZIPFIAN) {
+        cout<<"-scandist must be uniform or zipfian"<<endl;
+        return 1;
+    }
+    if(ycsb.max_scan_len < 1) {
+        cout<<"-scanlen must be at least 1"<<endl;
+        return 1;
+    }
+    if(opfilename != NULL && ycsb_enabled) {
+        cout<<"-opfile cannot be combined with -rw, -ycsb or -mix"<<endl;
+        return 1;
+    }
+    if(record_path != NULL && (!ycsb_enabled || slo_us > 0)) {
+        cout<<"-record needs -ycsb, -mix or -rw (and no -slo_p99)"<<endl;
+        return 1;
+    }
+    if(record_times && record_path == NULL) {
+        cout<<"-record_ts needs -record"<<endl;
+        return 1;
+    }
+    if(opfilename != NULL && is_trace_file(string(opfilename))) {
+        trace_layout layout = read_trace_layout(string(opfilename));
+        if(layout.nthreads != threadNum) {
+            cout<<opfilename<<" was recorded with "<<layout.nthreads<<" threads, replay it with -nthreads "<<layout.nthreads<<endl;
+            return 1;
+        }
+        if(replay_timed && !layout.timestamps) {
+            cout<<"-replay_timed needs a trace recorded with -record_ts"<<endl;
+            return 1;
+        }
+    }
+    else if(replay_timed) {
+        cout<<"-replay_timed needs an -opfile recorded with -record"<<endl;
+        return 1;
+    }
+    if(replay_timed && rate > 0) {
+        cout<<"-replay_timed cannot be combined with -rate"<<endl;
+        return 1;
+    }
+    if(dataset_split_fractions[0] > 0 && (filename == NULL || opfilename != NULL)) {
+        cout<<"-split needs -file, and cannot be combined with -opfile"<<endl;
+        return 1;
+    }
+    if(dataset_split_fractions[0] > 0 && exp_duration_ms > 0 && (dataset_split_fractions[1] <= 0 || dataset_split_fractions[2] <= 0)) {
+        cout<<"-split with -duration needs nonzero read and insert fractions"<<endl;
+        return 1;
+    }
+    if(str_key_format != STR_KEYS_NONE) {
+#ifndef DS_ADAPTER_SUPPORTS_STRING_KEYS
+        cout<<STR(DS_NAME)<<" does not support string keys (-keys)"<<endl;
+        return 1;
+#endif
+        if(!ycsb_record_keys() || ycsb.mix[scan_t] > 0 || slo_us > 0 || filename != NULL || opfilename != NULL
+           || numShards > 0 || bulk_fill > 0 || record_path != NULL) {
+            cout<<"-keys needs -ycsb or -mix without scans and a record request distribution, and cannot be"<<endl;
+            cout<<"combined with -slo_p99, -file, -opfile, -shards, -bulkload or -record"<<endl;
+            return 1;
+        }
+    }
+    if(ycsb_record_keys() && filename != NULL) {
+        cout<<"-file can only be combined with -reqdist pim"<<endl;
+        return 1;
+    }
+    if(bulk_fill < 0 || bulk_fill > 1) {
+        cout<<"-bulkload must be in (0, 1]"<<endl;
+        return 1;
+    }
+    if(churn_enabled()) {
+        if(churn_update > 1 || churn_range_factor <= 1 || init_n < 1 || churn_range_factor * init_n > KEY_RANGE) {
+            cout<<"-churn must be in [0, 1], and -churn_range greater than 1 and at most "<<KEY_RANGE<<" / -ninit"<<endl;
+            return 1;
+        }
+        if(ycsb_enabled || filename != NULL || opfilename != NULL || str_key_format != STR_KEYS_NONE
+           || bulk_fill > 0 || record_path != NULL || slo_us > 0) {
+            cout<<"-churn cannot be combined with -rw, -ycsb, -mix, -file, -opfile, -keys, -bulkload,"<<endl;
+            cout<<"-record or -slo_p99"<<endl;
+            return 1;
+        }
+        mem_stats_enabled = true;
+    }
+#ifndef DS_ADAPTER_SUPPORTS_MEMORY_STATS
+    if(mem_stats_enabled) {
+        cout<<STR(DS_NAME)<<" does not support -mem_stats (or -churn)"<<endl;
+        return 1;
+    }
+#endif
+    if(op_batch < 0 || (op_batch > 0 && (ycsb_enabled || churn_enabled() || opfilename != NULL || slo_us > 0
+                                         || rate > 0 || search_predecessor || bulk_fill > 0))) {
+        cout<<"-batch must be positive, and cannot be combined with -rw, -ycsb, -mix, -churn, -opfile,"<<endl;
+        cout<<"-slo_p99, -rate, -search pred or -bulkload"<<endl;
+        return 1;
+    }
+#ifndef DS_ADAPTER_SUPPORTS_BATCH
+    if(op_batch > 0) {
+        cout<<STR(DS_NAME)<<" does not support -batch"<<endl;
+        return 1;
+    }
+#endif
+#ifndef DS_ADAPTER_SUPPORTS_BULK_LOAD
+    if(bulk_fill > 0) {
+        cout<<STR(DS_NAME)<<" does not support -bulkload"<<endl;
+        return 1;
+    }
+#endif
+#ifndef DS_ADAPTER_SUPPORTS_RANGE_QUERY
+    if(ycsb_enabled && ycsb.mix[scan_t] > 0) {
+        cout<<STR(DS_NAME)<<" does not support range queries (scan)"<<endl;
+        return 1;
+    }
+#endif
+#ifndef DS_ADAPTER_SUPPORTS_ORDERED_SEARCH
+    if((ycsb_enabled && ycsb.mix[predecessor_t] > 0) || search_predecessor) {
+        cout<<STR(DS_NAME)<<" does not support predecessor lookups"<<endl;
+        return 1;
+    }
+#endif
+    if(test_n < 0) test_n = init_n / 5;
+
+    cout<<"data_structure="<<STR(DS_NAME)<<endl;
+    cout<<"reclaimer="<<STR(RECLAIM_TYPE)<<" allocator="<<STR(ALLOC_TYPE)<<" pool="<<STR(POOL_TYPE)<<endl;
+    cout<<"bind="<<placement_policy<<" prefill_mem="<<placement_prefill_mem_names[placement_prefill_mem]<<endl;
+    cout<<"nthreads="<<threadNum<<" skew="<<skewness<<" pim="<<pimNR<<" shards="<<numShards<<" keys="<<str_key_format_names[str_key_format]<<endl;
+    cout<<"hot_phases="<<hot_phases<<" hot_shift="<<hot_shift<<" hot_skews=";
+    for(int i = 0; i < hot_num_skews; i++) cout<<(i ? "," : "")<<hot_skews[i];
+    cout<<endl;
+    if(rate > 0) cout<<"rate="<<rate<<" arrival="<<openloop_arrival_names[openloop_arrival]<<endl;
+    if(op_batch > 0) cout<<"batch="<<op_batch<<endl;
+    if(exp_duration_ms > 0) cout<<"duration_ms="<<exp_duration_ms<<" interval_ms="<<exp_interval_ms<<endl;
+
+    if(rand_base_seed >= 0) cout<<"seed="<<rand_base_seed<<endl;
+    if(record_path != NULL) cout<<"record="<<record_path<<" record_ts="<<record_times<<endl;
+
+    seed_and_print(0);
+
+    rand_hotspot_init(&hot_dist, pimNR, KEY_RANGE, hot_phases, hot_shift, hot_skews, hot_num_skews);
+
+    string workload = "search,insert";
+    if(op_batch > 0) workload += ",batch=" + to_string(op_batch);
+    if(opfilename != NULL) workload = string("replay:") + opfilename;
+    else if(churn_enabled()) workload = "churn:update=" + results_number(churn_update) + ",range=" + results_number(churn_range_factor);
+    else if(ycsb_enabled) {
+        workload = "";
+        for(int op = 0; op < OPERATION_NR_ITEMS; op++)
+            if(ycsb.mix[op] > 0) workload += (workload.empty() ? "" : ",") + string(operation_names[op]) + "=" + results_number(ycsb.mix[op]);
+    }
+    results_set("data_structure", STR(DS_NAME));
+    results_set("reclaimer", STR(RECLAIM_TYPE));
+    results_set("allocator", STR(ALLOC_TYPE));
+    results_set("pool", STR(POOL_TYPE));
+    results_set("workload", workload);
+    results_set("keys", str_key_format_names[str_key_format]);
+    results_set("ninit", to_string(init_n), true);
+    results_set("skew", results_number(skewness), true);
+    results_set("shards", to_string(numShards), true);
+    results_set("bind", placement_policy);
+    if(sweep_spec != NULL) {
+        cout<<"sweep_threads=";
+        for(size_t i = 0; i < sweep_threads.size(); i++) cout<<(i ? "," : "")<<sweep_threads[i];
+        cout<<" sweep_rebuild="<<sweep_rebuild<<endl;
+    }
+
+    // with -sweep_rebuild, a new data structure for every thread count of the sweep
+    for(int tnum : (sweep_rebuild ? sweep_threads : vector<int>(1, threadNum))) {
+        threadNum = tnum;
+#ifdef DS_ADAPTER_SUPPORTS_STRING_KEYS
+        if(str_key_format != STR_KEYS_NONE) {
+            auto tree = new STR_DATA_STRUCTURE_ADAPTER_T(threadNum, str_key(), str_key(), (void *) (uintptr_t) -1, NULL);
+            run_string_experiment(tree, init_n, test_n);
+            delete tree;
+            continue;
+        }
+#endif
+        if(numShards > 0) {
+            // shard boundaries line up with the hotspot partitions when -shards equals -pim
+            auto tree = new SHARDED_ADAPTER_T(threadNum, KEY_MIN, KEY_MAX, (void *) (uintptr_t) -1, NULL, numShards, 0, KEY_RANGE);
+            run_experiment(tree, init_n, test_n, filename, opfilename, stream_chunk, bulk_fill, slo_us, slo_steps);
+            delete tree;
+        }
+        else {
+            auto tree = new DATA_STRUCTURE_ADAPTER_T(threadNum, KEY_MIN, KEY_MAX, (void *) (uintptr_t) -1, NULL);
+            run_experiment(tree, init_n, test_n, filename, opfilename, stream_chunk, bulk_fill, slo_us, slo_steps);
+            delete tree;
+        }
+    }
+    sweep_print_summary();
+    results_close();
+
+    rand_hotspot_free(&hot_dist);
+
+    return 0;
+}
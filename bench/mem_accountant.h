@@ -0,0 +1,178 @@
+#pragma once
+
+/**
+ * Memory footprint per key, sampled over a run (-mem_stats).
+ *
+ * The memory the process gained since the start of the prefill is split in
+ * three components:
+ *   live      nodes of the data structure: the nodes allocated and not yet
+ *             freed, minus those in limbo
+ *   limbo     nodes that were removed and retired, and wait in the epoch bags
+ *             of the reclaimer until no thread can still be accessing them
+ *   overhead  the rest of the growth of the resident set: allocator headers
+ *             and fragmentation, freed memory the allocator keeps, and the
+ *             reclaimer's bags (plus anything else the harness allocated
+ *             since, e.g., for -record). it is negative if memory that was
+ *             resident when the prefill started has been returned since.
+ *
+ * The node counts come from the record manager (the allocator's counters,
+ * and getSizeInNodes of the reclaimer), which the main thread can read while
+ * the workers run, and the resident set from /proc/self/statm. They are
+ * sampled after every throughput sample of timed_run.h, and once more at the
+ * end of the phase. The driver counts the keys in the data structure as its
+ * inserts and erases succeed (mem_count_keys), so bytes per key follows
+ * workloads that grow or shrink the data structure.
+ *
+ * mem_phase_print prints each component in bytes per key for every sample,
+ * next to Throughput_series, and the totals at the end of the phase.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "plaf.h"
+#include "timed_run.h"
+
+struct mem_sample {
+    uint64_t time_ns;
+    long long live;     // nodes
+    long long limbo;    // nodes
+    long long freed;    // nodes freed since the data structure was created
+    int64_t rss;        // bytes
+    int64_t keys;
+};
+
+struct mem_thread_keys {
+    volatile int64_t n;
+    char pad[PREFETCH_SIZE_BYTES - sizeof(int64_t)];
+};
+
+bool mem_stats_enabled = false;
+PAD;
+mem_thread_keys mem_keys[MAX_THREADS_POW2];
+PAD;
+
+void * mem_tree = NULL;
+void (*mem_read_tree)(void * tree, size_t * node_bytes, long long * outstanding, long long * limbo, long long * freed) = NULL;
+size_t mem_node_bytes = 0;
+int64_t mem_baseline_rss = 0;
+std::vector<mem_sample> mem_samples;
+
+// the phase that mem_phase_print last printed: its first sample (taken by
+// mem_phase_begin, if it was called before the phase), its last sample, and
+// the largest limbo seen in between
+mem_sample mem_phase_first;
+mem_sample mem_phase_last;
+long long mem_phase_peak_limbo = 0;
+
+// thread tid added n keys to the data structure (or removed -n)
+static inline void mem_count_keys(int tid, int64_t n) {
+    mem_keys[tid].n = mem_keys[tid].n + n;
+}
+
+static int64_t mem_total_keys() {
+    int64_t total = 0;
+    for (int tid = 0; tid < MAX_THREADS_POW2; tid++) total += mem_keys[tid].n;
+    return total;
+}
+
+static int64_t mem_resident_bytes() {
+    long long size = 0, resident = 0;
+    FILE * f = fopen("/proc/self/statm", "r");
+    if (f == NULL) return 0;
+    if (fscanf(f, "%lld %lld", &size, &resident) != 2) resident = 0;
+    fclose(f);
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+template<class DATA_STRUCTURE_ADAPTER>
+static void mem_read_adapter(void * tree, size_t * node_bytes, long long * outstanding, long long * limbo, long long * freed) {
+#ifdef DS_ADAPTER_SUPPORTS_MEMORY_STATS
+    ((DATA_STRUCTURE_ADAPTER *) tree)->getMemoryStats(node_bytes, outstanding, limbo, freed);
+#else
+    *node_bytes = 0;
+    *outstanding = 0;
+    *limbo = 0;
+    *freed = 0;
+#endif
+}
+
+static mem_sample mem_read_sample(uint64_t now_ns) {
+    long long outstanding, limbo, freed;
+    mem_read_tree(mem_tree, &mem_node_bytes, &outstanding, &limbo, &freed);
+    mem_sample s;
+    s.time_ns = now_ns;
+    s.live = outstanding - limbo;
+    s.limbo = limbo;
+    s.freed = freed;
+    s.rss = mem_resident_bytes();
+    s.keys = mem_total_keys();
+    return s;
+}
+
+static void mem_take_sample(uint64_t now_ns) {
+    mem_samples.push_back(mem_read_sample(now_ns));
+}
+
+// starts accounting for tree, which is about to be prefilled
+template<class DATA_STRUCTURE_ADAPTER>
+void mem_attach(DATA_STRUCTURE_ADAPTER * tree) {
+    for (int tid = 0; tid < MAX_THREADS_POW2; tid++) mem_keys[tid].n = 0;
+    if (!mem_stats_enabled) return;
+    mem_tree = tree;
+    mem_read_tree = mem_read_adapter<DATA_STRUCTURE_ADAPTER>;
+    mem_baseline_rss = mem_resident_bytes();
+    mem_samples.clear();
+    exp_sample_hook = mem_take_sample;
+}
+
+// samples the state before a phase starts, for the growth over the phase (see
+// mem_phase_first). must not run concurrently with a phase.
+void mem_phase_begin() {
+    if (!mem_stats_enabled) return;
+    mem_phase_first = mem_read_sample(exp_now_ns());
+}
+
+static double mem_per_key(double bytes, int64_t keys) {
+    return (keys > 0) ? bytes / keys : 0;
+}
+
+// takes a last sample of the phase that just ended, prints the series of the
+// phase in bytes per key and the totals, and starts the series of the next one
+void mem_phase_print() {
+    if (!mem_stats_enabled) return;
+    mem_take_sample(exp_end_ns);
+    const mem_sample & last = mem_samples.back();
+
+    std::cout << "Memory_series_interval_ms=" << exp_interval_ms << " live_bytes_per_key:";
+    for (const mem_sample & s : mem_samples) std::cout << " " << mem_per_key((double) s.live * mem_node_bytes, s.keys);
+    std::cout << std::endl;
+    std::cout << "Memory_series_interval_ms=" << exp_interval_ms << " limbo_bytes_per_key:";
+    for (const mem_sample & s : mem_samples) std::cout << " " << mem_per_key((double) s.limbo * mem_node_bytes, s.keys);
+    std::cout << std::endl;
+    std::cout << "Memory_series_interval_ms=" << exp_interval_ms << " overhead_bytes_per_key:";
+    for (const mem_sample & s : mem_samples) {
+        double overhead = (double) (s.rss - mem_baseline_rss) - (double) (s.live + s.limbo) * mem_node_bytes;
+        std::cout << " " << mem_per_key(overhead, s.keys);
+    }
+    std::cout << std::endl;
+
+    long long peak_limbo = 0;
+    for (const mem_sample & s : mem_samples) peak_limbo = std::max(peak_limbo, s.limbo);
+    mem_phase_last = last;
+    mem_phase_peak_limbo = peak_limbo;
+    double live = (double) last.live * mem_node_bytes;
+    double limbo = (double) last.limbo * mem_node_bytes;
+    double overhead = (double) (last.rss - mem_baseline_rss) - live - limbo;
+    const double mb = 1024.0 * 1024;
+    std::cout << "Memory: keys=" << last.keys << " node_bytes=" << mem_node_bytes
+              << " live_nodes=" << last.live << " limbo_nodes=" << last.limbo
+              << " live_mb=" << live / mb << " limbo_mb=" << limbo / mb << " limbo_peak_mb=" << peak_limbo * mem_node_bytes / mb
+              << " overhead_mb=" << overhead / mb << " bytes_per_key=" << mem_per_key(live + limbo + overhead, last.keys) << std::endl;
+
+    mem_samples.clear();
+}
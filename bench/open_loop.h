@@ -0,0 +1,111 @@
+#pragma once
+
+/**
+ * Open-loop load generation.
+ *
+ * In the default closed loop, a thread issues its next operation as soon as
+ * the previous one returns, so a slow operation also delays every operation
+ * queued behind it without that delay showing up in any latency (coordinated
+ * omission). In open-loop mode every thread follows its own schedule of send
+ * times, at openloop_rate / nthreads operations per second, with exponential
+ * (Poisson arrivals) or constant gaps. A thread waits for the send time of
+ * its next operation, or issues it immediately if it is already late, and
+ * the latency of the operation is measured from its intended send time, so
+ * it includes the time spent waiting behind earlier operations.
+ *
+ * Usage in a worker loop:
+ *   exp_thread_ready(tid); openloop_thread_start(tid);
+ *   for (...) { ...; if (!openloop_send_time(tid, &t0)) break; <operation>; lat_stop(tid, op, t0); }
+ *   exp_thread_done(tid); openloop_thread_done(tid);
+ * With openloop_rate == 0, openloop_send_time() simply sets t0 to the current time.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <iostream>
+
+#include "plaf.h"
+#include "latency.h"
+#include "timed_run.h"
+#include "zipf.h"
+
+#define OPENLOOP_POISSON 0
+#define OPENLOOP_CONSTANT 1
+const char * const openloop_arrival_names[] = {"poisson", "constant"};
+
+struct openloop_thread_state {
+    double next;        // intended send time of the next operation, in TSC ticks
+    double gap;         // mean gap between send times, in TSC ticks
+    double lag;         // how far behind schedule the thread was at the end of the phase
+    char pad[PREFETCH_SIZE_BYTES - 3 * sizeof(double)];
+};
+
+double openloop_rate = 0;   // aggregate target rate in Mops/s, or 0 for closed loop
+int openloop_arrival = OPENLOOP_POISSON;
+int openloop_threads = 1;   // number of threads sharing the rate
+openloop_thread_state openloop_state[MAX_THREADS_POW2];
+
+bool openloop_parse_arrival(const char * name) {
+    for (int i = 0; i < 2; i++) {
+        if (strcmp(name, openloop_arrival_names[i]) == 0) {
+            openloop_arrival = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// sets the aggregate rate (Mops/s) that nthreads threads will generate in the next phase
+void openloop_set_rate(double rate, int nthreads) {
+    openloop_rate = rate;
+    openloop_threads = nthreads;
+}
+
+// must be called by thread tid when it is released by the start barrier
+void openloop_thread_start(int tid) {
+    if (openloop_rate <= 0) return;
+    openloop_state[tid].gap = openloop_threads * 1000.0 / openloop_rate * lat_ticks_per_ns;
+    openloop_state[tid].next = read_tsc();
+    openloop_state[tid].lag = 0;
+}
+
+// waits for the send time of the next operation and sets send to it (in TSC
+// ticks). in timed phases, stops waiting when the phase ends, and then returns
+// false: the operation was not due yet, and must be neither issued nor recorded.
+static inline bool openloop_send_time(int tid, uint64_t * send) {
+    if (openloop_rate <= 0) {
+        *send = lat_start();
+        return true;
+    }
+    openloop_thread_state * s = &openloop_state[tid];
+    *send = (uint64_t) s->next;
+    while (read_tsc() < *send) {
+        if (exp_stop) {
+            *send = read_tsc();
+            return false;
+        }
+    }
+    double gap = s->gap;
+    if (openloop_arrival == OPENLOOP_POISSON) {
+        double u = rand_double(tid);
+        gap *= -log1p(-(u < 1 ? u : 0.999999999));
+    }
+    s->next += gap;
+    return true;
+}
+
+void openloop_thread_done(int tid) {
+    if (openloop_rate <= 0) return;
+    double lag = read_tsc() - openloop_state[tid].next;
+    openloop_state[tid].lag = (lag > 0) ? lag : 0;
+}
+
+// prints the offered rate and how far behind schedule the threads ended the phase
+void openloop_print(int tnum) {
+    if (openloop_rate <= 0) return;
+    double max_lag = 0;
+    for (int tid = 0; tid < tnum; tid++) max_lag = std::max(max_lag, openloop_state[tid].lag);
+    std::cout << "Offered_rate: " << openloop_rate << " arrival=" << openloop_arrival_names[openloop_arrival]
+              << " max_schedule_lag_us=" << max_lag / lat_ticks_per_ns / 1000 << std::endl;
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+/**
+ * Per-thread hardware event counting, with PAPI or (when the driver is
+ * built without USE_PAPI) directly with Linux perf_event_open, see
+ * perf_exp.h. Both backends take the same event names and print the same
+ * report.
+ *
+ * The events are taken from -papi_events, else from the PAPI_EVENTS
+ * environment variable, else the backend's default list. Names are
+ * resolved, and PAPI thread support and (if the list has more events than
+ * the CPU has counters) multiplexing are set up once, by papi_exp_init_lib.
+ * Each worker then counts its own events from papi_exp_start_counter to
+ * papi_exp_stop_counter. With multiplexing, the counts are estimates scaled
+ * by the time each event was actually counted.
+ *
+ * papi_exp_print_counters prints each event per operation for the phase,
+ * then the derived metrics its inputs are available for, both aggregated
+ * and per thread: IPC, L1/L2/LLC and dTLB misses per kilo-instruction, and
+ * the branch misprediction rate.
+ */
+
+#include <sys/mman.h>
+#include <stdio.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/time.h>
+#include <ctime>
+
+#include "thread_state.h"
+
+using std::cout; using std::endl;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::system_clock;
+
+using namespace std;
+
+#define PAPI_MAX_EVENTS 16
+
+string papi_event_names[PAPI_MAX_EVENTS];
+int papi_event_codes[PAPI_MAX_EVENTS];
+int papi_num_events = 0;
+bool papi_multiplex = false;
+const char * papi_events_spec = NULL;
+long long * papi_values[MAX_THREADS_POW2];  // PAPI_MAX_EVENTS values per thread, see papi_thread_values
+
+// zeroes the event values of thread tid for a new phase. the thread allocates
+// (first touch) them the first time.
+static long long * papi_thread_values(int tid) {
+	thread_state_check(tid, "papi_exp_start_counter");
+	if (papi_values[tid] == NULL) papi_values[tid] = (long long *) thread_state_alloc(PAPI_MAX_EVENTS * sizeof(long long));
+	else memset(papi_values[tid], 0, PAPI_MAX_EVENTS * sizeof(long long));
+	return papi_values[tid];
+}
+
+// sets the comma separated list of events to count (overrides PAPI_EVENTS)
+bool papi_exp_set_events(const char * list) {
+	if (list == NULL || list[0] == '\0') return false;
+	papi_events_spec = list;
+	return true;
+}
+
+// the events to count: -papi_events, else $PAPI_EVENTS, else default_spec
+static vector<string> papi_event_list(const char * default_spec) {
+	const char * spec = papi_events_spec;
+	if (spec == NULL) spec = getenv("PAPI_EVENTS");
+	if (spec == NULL || spec[0] == '\0') spec = default_spec;
+	vector<string> names;
+	string s(spec);
+	size_t pos = 0;
+	while (pos < s.size()) {
+		size_t end = s.find(',', pos);
+		if (end == string::npos) end = s.size();
+		if (end > pos) names.push_back(s.substr(pos, end - pos));
+		pos = end + 1;
+	}
+	if (names.size() > PAPI_MAX_EVENTS) {
+		printf("at most %d events can be counted\n", PAPI_MAX_EVENTS);
+		exit(1);
+	}
+	return names;
+}
+
+// index of the first of the given events that is being counted, or -1
+static int papi_find_event(const char * a, const char * b = NULL) {
+	for (int i = 0; i < papi_num_events; i++)
+		if (papi_event_names[i] == a) return i;
+	return (b == NULL) ? -1 : papi_find_event(b);
+}
+
+// prints the metrics that can be derived from the counted events in values
+static void papi_print_derived(string label, long long * values) {
+	int cyc = papi_find_event("PAPI_TOT_CYC", "PAPI_REF_CYC");
+	int ins = papi_find_event("PAPI_TOT_INS");
+	int l1 = papi_find_event("PAPI_L1_DCM", "PAPI_L1_TCM");
+	int l2 = papi_find_event("PAPI_L2_TCM", "PAPI_L2_DCM");
+	int llc = papi_find_event("PAPI_L3_TCM", "PAPI_L3_DCM");
+	int tlb = papi_find_event("PAPI_TLB_DM");
+	int brm = papi_find_event("PAPI_BR_MSP");
+	int br = papi_find_event("PAPI_BR_CN", "PAPI_BR_INS");
+	auto ratio = [&](int num, int den, double scale) {
+		return (values[den] > 0) ? scale * values[num] / values[den] : 0;
+	};
+	if (ins < 0 && (brm < 0 || br < 0)) return;
+	cout << label;
+	if (ins >= 0 && cyc >= 0)
+		cout << " ipc=" << ratio(ins, cyc, 1);
+	if (ins >= 0) {
+		if (l1 >= 0) cout << " l1_mpki=" << ratio(l1, ins, 1000);
+		if (l2 >= 0) cout << " l2_mpki=" << ratio(l2, ins, 1000);
+		if (llc >= 0) cout << " llc_mpki=" << ratio(llc, ins, 1000);
+		if (tlb >= 0) cout << " dtlb_mpki=" << ratio(tlb, ins, 1000);
+	}
+	if (brm >= 0 && br >= 0)
+		cout << " branch_miss_rate=" << ratio(brm, br, 1);
+	cout << endl;
+}
+
+void papi_exp_print_counters(int64_t opsNum, int threadNum) {
+	long long print_values[PAPI_MAX_EVENTS] = {0};
+	for(int i = 0; i < threadNum; i++) {
+		if (papi_values[i] == NULL) continue;
+		for(int j = 0; j < papi_num_events; j++)
+			print_values[j] += papi_values[i][j];
+	}
+	for (int j = 0; j < papi_num_events; j++)
+		cout << papi_event_names[j] << ": " << ((double)print_values[j] / opsNum) << endl;
+	papi_print_derived("papi_derived", print_values);
+	for (int i = 0; i < threadNum; i++)
+		if (papi_values[i] != NULL) papi_print_derived("papi_derived_tid" + to_string(i), papi_values[i]);
+}
+
+#ifdef USE_PAPI
+
+#include "papi.h"
+
+#define PAPI_DEFAULT_EVENTS "PAPI_L3_TCM,PAPI_REF_CYC,PAPI_TOT_INS,PAPI_L2_TCM"
+
+void papi_exp_init_lib() {
+	// once per process, even if several data structures are measured (-sweep_rebuild)
+	static bool initialized = false;
+	if (initialized) return;
+	initialized = true;
+    if(PAPI_library_init(PAPI_VER_CURRENT) != PAPI_VER_CURRENT) {
+		printf("PAPI_library_init fail\n");
+		exit(1);
+	}
+	if(PAPI_thread_init(pthread_self) != PAPI_OK) {
+		printf("PAPI_thread_init fail\n");
+		exit(1);
+	}
+
+	papi_num_events = 0;
+	for (string & name : papi_event_list(PAPI_DEFAULT_EVENTS)) {
+		int code;
+		int papi_retval = PAPI_event_name_to_code((char *) name.c_str(), &code);
+		if (papi_retval != PAPI_OK) {
+			printf("PAPI event %s not found: %s\n", name.c_str(), PAPI_strerror(papi_retval));
+			exit(1);
+		}
+		papi_event_names[papi_num_events] = name;
+		papi_event_codes[papi_num_events++] = code;
+	}
+
+	int counters = PAPI_num_cmp_hwctrs(0);
+	papi_multiplex = counters > 0 && papi_num_events > counters;
+	if (papi_multiplex && PAPI_multiplex_init() != PAPI_OK) {
+		printf("PAPI_multiplex_init fail\n");
+		exit(1);
+	}
+	cout << "papi_events=";
+	for (int i = 0; i < papi_num_events; i++) cout << (i ? "," : "") << papi_event_names[i];
+	cout << " papi_hw_counters=" << counters << " papi_multiplex=" << papi_multiplex << endl;
+}
+
+int papi_exp_start_counter(int tid) {
+		papi_thread_values(tid);
+		int papi_event = PAPI_NULL;
+		int papi_retval = PAPI_create_eventset(&papi_event);
+		if(papi_retval != PAPI_OK){
+			printf("PAPI create event fail\n");
+			exit(-1);
+		}
+		if (papi_multiplex) {
+			// a multiplexed event set must be bound to a component before it is converted
+			if (PAPI_assign_eventset_component(papi_event, 0) != PAPI_OK || PAPI_set_multiplex(papi_event) != PAPI_OK) {
+				printf("PAPI set multiplex fail\n");
+				exit(-1);
+			}
+		}
+		papi_retval = PAPI_add_events(papi_event, papi_event_codes, papi_num_events);
+		if(papi_retval != PAPI_OK){
+			printf("PAPI add event fail: %d (%s)\n", papi_retval, PAPI_strerror(papi_retval));
+			exit(-1);
+		}
+		if(PAPI_start(papi_event) != PAPI_OK){
+			printf("PAPI_start fail\n");
+			exit(-1);
+		}
+        return papi_event;
+}
+
+void papi_exp_stop_counter(int tid, int papi_event) {
+        if(PAPI_stop(papi_event, papi_values[tid]) != PAPI_OK){
+			printf("PAPI_stop fail\n");
+			exit(1);
+		}
+		if(PAPI_cleanup_eventset(papi_event) != PAPI_OK){
+			printf("PAPI_cleanup_eventset fail\n");
+			exit(1);
+		}
+		if(PAPI_destroy_eventset(&papi_event) != PAPI_OK){
+			printf("PAPI_destroy_eventset fail\n");
+			exit(1);
+		}
+}
+
+#else
+
+#include "perf_exp.h"
+
+#endif
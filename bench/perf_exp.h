@@ -0,0 +1,207 @@
+#pragma once
+
+/**
+ * perf_event_open backend of papi_exp.h, for hosts without PAPI.
+ *
+ * Understands the PAPI preset names that have a generic perf equivalent
+ * (so -papi_events lists and the derived metrics work unchanged), the
+ * equivalent perf tool names (cycles, instructions, ...), a few software
+ * events, and raw events as r<hex>. L2 misses have no generic perf event,
+ * so PAPI_L2_TCM needs the raw event of the CPU at hand.
+ *
+ * Each worker opens its events for itself (user mode only), in groups of at
+ * most PERF_GROUP_SIZE events that the kernel schedules on the PMU together.
+ * With more than one group, the kernel multiplexes them, and counts are
+ * scaled by time enabled / time running. With a single group, and if the
+ * kernel allows user space rdpmc, counters are read with rdpmc through the
+ * mmap'd page of each event instead of read() system calls.
+ *
+ * If an event cannot be opened (no PMU, or perf_event_paranoid too high) a
+ * warning is printed once and that thread counts nothing.
+ */
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define PERF_GROUP_SIZE 4
+#define PAPI_DEFAULT_EVENTS "PAPI_TOT_CYC,PAPI_TOT_INS,PAPI_L1_DCM,PAPI_L3_TCM"
+
+#define PERF_CACHE_MISS(cache) ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+struct perf_event_name {
+    const char * papi_name;
+    const char * perf_name;
+    uint32_t type;
+    uint64_t config;
+};
+
+const perf_event_name perf_event_table[] = {
+    {"PAPI_TOT_CYC", "cycles",                PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"PAPI_REF_CYC", "ref-cycles",            PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES},
+    {"PAPI_TOT_INS", "instructions",          PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"PAPI_L1_DCM",  "L1-dcache-load-misses", PERF_TYPE_HW_CACHE, PERF_CACHE_MISS(PERF_COUNT_HW_CACHE_L1D)},
+    {"PAPI_L3_TCM",  "cache-misses",          PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"PAPI_L3_DCM",  "LLC-load-misses",       PERF_TYPE_HW_CACHE, PERF_CACHE_MISS(PERF_COUNT_HW_CACHE_LL)},
+    {"PAPI_TLB_DM",  "dTLB-load-misses",      PERF_TYPE_HW_CACHE, PERF_CACHE_MISS(PERF_COUNT_HW_CACHE_DTLB)},
+    {"PAPI_BR_MSP",  "branch-misses",         PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"PAPI_BR_INS",  "branches",              PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+    {"task-clock",   "task-clock",            PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+    {"page-faults",  "page-faults",           PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    {"context-switches", "context-switches",  PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+    {"cpu-migrations", "cpu-migrations",      PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS},
+};
+
+struct perf_thread_state {
+    int fd[PAPI_MAX_EVENTS];
+    perf_event_mmap_page * page[PAPI_MAX_EVENTS];
+    bool rdpmc;
+    long long start[PAPI_MAX_EVENTS];
+};
+
+uint32_t perf_event_types[PAPI_MAX_EVENTS];
+uint64_t perf_event_configs[PAPI_MAX_EVENTS];
+perf_thread_state * perf_state[MAX_THREADS_POW2];    // allocated by each thread in papi_exp_start_counter
+volatile bool perf_warned = false;
+
+void papi_exp_init_lib() {
+	papi_num_events = 0;
+	for (string & name : papi_event_list(PAPI_DEFAULT_EVENTS)) {
+		int i = papi_num_events;
+		size_t k = 0;
+		while (k < sizeof(perf_event_table) / sizeof(perf_event_table[0])
+				&& name != perf_event_table[k].papi_name && name != perf_event_table[k].perf_name) k++;
+		if (k < sizeof(perf_event_table) / sizeof(perf_event_table[0])) {
+			// reported under its PAPI name, so derived metrics find it
+			papi_event_names[i] = perf_event_table[k].papi_name;
+			perf_event_types[i] = perf_event_table[k].type;
+			perf_event_configs[i] = perf_event_table[k].config;
+		}
+		else if (name.size() > 1 && name[0] == 'r' && name.find_first_not_of("0123456789abcdefABCDEF", 1) == string::npos) {
+			papi_event_names[i] = name;
+			perf_event_types[i] = PERF_TYPE_RAW;
+			perf_event_configs[i] = strtoull(name.c_str() + 1, NULL, 16);
+		}
+		else {
+			printf("perf event %s not supported (use a raw event r<hex>)\n", name.c_str());
+			exit(1);
+		}
+		papi_num_events++;
+	}
+	papi_multiplex = papi_num_events > PERF_GROUP_SIZE;
+	cout << "papi_events=";
+	for (int i = 0; i < papi_num_events; i++) cout << (i ? "," : "") << papi_event_names[i];
+	cout << " counters=perf_event perf_groups=" << (papi_num_events + PERF_GROUP_SIZE - 1) / PERF_GROUP_SIZE
+	     << " papi_multiplex=" << papi_multiplex << endl;
+}
+
+static void perf_close_all(perf_thread_state * st) {
+	for (int i = 0; i < papi_num_events; i++) {
+		if (st->page[i] != NULL) munmap(st->page[i], sysconf(_SC_PAGESIZE));
+		if (st->fd[i] >= 0) close(st->fd[i]);
+		st->page[i] = NULL;
+		st->fd[i] = -1;
+	}
+}
+
+static inline uint64_t perf_rdpmc(uint32_t counter) {
+	uint32_t lo, hi;
+	__asm__ __volatile__("rdpmc" : "=a" (lo), "=d" (hi) : "c" (counter));
+	return lo | ((uint64_t) hi << 32);
+}
+
+// reads the current counts of thread st (no scaling: rdpmc is only used with a single group)
+static void perf_read_rdpmc(perf_thread_state * st, long long * values) {
+	for (int i = 0; i < papi_num_events; i++) {
+		perf_event_mmap_page * pc = st->page[i];
+		uint32_t seq;
+		int64_t count;
+		do {
+			seq = pc->lock;
+			__asm__ __volatile__("" ::: "memory");
+			count = pc->offset;
+			if (pc->index) {
+				int64_t pmc = perf_rdpmc(pc->index - 1);
+				pmc <<= 64 - pc->pmc_width;
+				pmc >>= 64 - pc->pmc_width;
+				count += pmc;
+			}
+			__asm__ __volatile__("" ::: "memory");
+		} while (pc->lock != seq);
+		values[i] = count;
+	}
+}
+
+// reads the counts of thread st with read() on each group leader, scaled by
+// enabled / running time if the group was multiplexed
+static void perf_read_groups(perf_thread_state * st, long long * values) {
+	uint64_t buf[3 + PERF_GROUP_SIZE];
+	for (int g = 0; g < papi_num_events; g += PERF_GROUP_SIZE) {
+		int n = min(PERF_GROUP_SIZE, papi_num_events - g);
+		if (read(st->fd[g], buf, sizeof(buf)) < (ssize_t) ((3 + n) * sizeof(uint64_t))) {
+			for (int i = 0; i < n; i++) values[g + i] = 0;
+			continue;
+		}
+		// buf: nr, time_enabled, time_running, value[nr]
+		double scale = (buf[2] > 0) ? (double) buf[1] / buf[2] : 0;
+		for (int i = 0; i < n; i++) values[g + i] = (long long) (buf[3 + i] * scale);
+	}
+}
+
+int papi_exp_start_counter(int tid) {
+		papi_thread_values(tid);
+		if (perf_state[tid] == NULL) perf_state[tid] = (perf_thread_state *) thread_state_alloc(sizeof(perf_thread_state));
+		perf_thread_state * st = perf_state[tid];
+		for (int i = 0; i < papi_num_events; i++) {
+			st->fd[i] = -1;
+			st->page[i] = NULL;
+		}
+		for (int i = 0; i < papi_num_events; i++) {
+			perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = perf_event_types[i];
+			attr.config = perf_event_configs[i];
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+			bool leader = (i % PERF_GROUP_SIZE == 0);
+			attr.disabled = leader;
+			st->fd[i] = syscall(__NR_perf_event_open, &attr, 0, -1, leader ? -1 : st->fd[i - i % PERF_GROUP_SIZE], 0);
+			if (st->fd[i] < 0) {
+				if (!__sync_lock_test_and_set(&perf_warned, true))
+					printf("WARNING: perf_event_open failed for %s: %s; counters will read 0\n",
+					       papi_event_names[i].c_str(), strerror(errno));
+				perf_close_all(st);
+				return -1;
+			}
+		}
+		st->rdpmc = !papi_multiplex;
+		for (int i = 0; i < papi_num_events && st->rdpmc; i++) {
+			void * p = mmap(NULL, sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, st->fd[i], 0);
+			if (p == MAP_FAILED) st->rdpmc = false;
+			else st->page[i] = (perf_event_mmap_page *) p;
+		}
+		for (int g = 0; g < papi_num_events; g += PERF_GROUP_SIZE) {
+			ioctl(st->fd[g], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+			ioctl(st->fd[g], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		}
+		// user space rdpmc works once the events are scheduled on this thread's PMU
+		for (int i = 0; i < papi_num_events && st->rdpmc; i++)
+			if (!st->page[i]->cap_user_rdpmc || st->page[i]->index == 0) st->rdpmc = false;
+		if (st->rdpmc) perf_read_rdpmc(st, st->start);
+		else memset(st->start, 0, sizeof(st->start));
+		return tid;
+}
+
+void papi_exp_stop_counter(int tid, int papi_event) {
+		if (papi_event < 0) return;
+		perf_thread_state * st = perf_state[tid];
+		if (st->rdpmc) {
+			perf_read_rdpmc(st, papi_values[tid]);
+			for (int i = 0; i < papi_num_events; i++) papi_values[tid][i] -= st->start[i];
+		}
+		else perf_read_groups(st, papi_values[tid]);
+		perf_close_all(st);
+}
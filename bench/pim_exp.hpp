@@ -0,0 +1,344 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+
+using namespace std;
+
+enum operation_t {
+    empty_t,
+    get_t,
+    update_t,
+    predecessor_t,
+    scan_t,
+    insert_t,
+    remove_t,
+    rmw_t
+};
+const int OPERATION_NR_ITEMS = 8;
+const char * const operation_names[OPERATION_NR_ITEMS] = {
+    "empty", "get", "update", "predecessor", "scan", "insert", "remove", "rmw"
+};
+
+int op_count[OPERATION_NR_ITEMS];
+struct get_operation {
+    int64_t key;
+};
+
+struct update_operation {
+    int64_t key;
+    int64_t value;
+};
+
+struct predecessor_operation {
+    int64_t key;
+};
+
+int scan_start = 0;
+struct scan_operation {
+    int64_t lkey;
+    int64_t rkey;
+};
+
+struct insert_operation {
+    int64_t key;
+    int64_t value;
+};
+
+struct remove_operation {
+    int64_t key;
+};
+
+struct operation {
+    union {
+        get_operation g;
+        update_operation u;
+        predecessor_operation p;
+        scan_operation s;
+        insert_operation i;
+        remove_operation r;
+    } tsk;
+    operation_t type;
+};
+
+// maps a whole trace file of elem_size byte entries and stores the number of
+// entries in n. with populate, every page is faulted in here (MAP_POPULATE),
+// so that the first pass over the trace does not page fault inside a measured
+// phase. otherwise the kernel is only asked to read the file ahead.
+void* map_trace_file(string name, size_t elem_size, int64_t* n, bool populate) {
+    const char* filepath = name.c_str();
+
+    int fd = open(filepath, O_RDONLY, (mode_t)0600);
+
+    if (fd == -1) {
+        perror("Error opening file for reading");
+        exit(EXIT_FAILURE);
+    }
+
+    struct stat fileInfo;
+
+    if (fstat(fd, &fileInfo) == -1) {
+        perror("Error getting the file size");
+        exit(EXIT_FAILURE);
+    }
+
+    if (fileInfo.st_size == 0) {
+        fprintf(stderr, "Error: File is empty, nothing to do\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (fileInfo.st_size % elem_size != 0) {
+        fprintf(stderr, "Error: File size %ji is not a multiple of %zu\n", (intmax_t)fileInfo.st_size, elem_size);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("File size is %ji\n", (intmax_t)fileInfo.st_size);
+
+    void* map = mmap(0, fileInfo.st_size, PROT_READ, MAP_SHARED | (populate ? MAP_POPULATE : 0), fd, 0);
+
+    if (map == MAP_FAILED) {
+        close(fd);
+        perror("Error mmapping the file");
+        exit(EXIT_FAILURE);
+    }
+    if (!populate) madvise(map, fileInfo.st_size, MADV_WILLNEED);
+    close(fd);
+
+    *n = fileInfo.st_size / elem_size;
+    return map;
+}
+
+struct ops_array {
+    int64_t n;
+    operation* operation_map;
+};
+
+ops_array read_op_file(string name, bool populate = true) {
+    ops_array operation_map;
+    operation_map.operation_map = (operation*) map_trace_file(name, sizeof(operation), &operation_map.n, populate);
+    return operation_map;
+}
+
+struct i64_array {
+    int64_t n;
+    int64_t* i64_map;
+};
+
+i64_array read_i64_file(string name, bool populate = true) {
+    i64_array operation_map;
+    operation_map.i64_map = (int64_t*) map_trace_file(name, sizeof(int64_t), &operation_map.n, populate);
+    return operation_map;
+}
+
+// number of elem_size byte entries in a trace file, without mapping it
+int64_t trace_file_entries(string name, size_t elem_size) {
+    struct stat fileInfo;
+    if (stat(name.c_str(), &fileInfo) == -1) {
+        perror("Error getting the file size");
+        exit(EXIT_FAILURE);
+    }
+    return fileInfo.st_size / elem_size;
+}
+
+/**
+ * Sequential reader over entries [begin, end) of a trace file that may be
+ * larger than memory. Only a window of chunk entries is mapped at a time.
+ * The window is populated when it is mapped, and the next one is read ahead
+ * with madvise(WILLNEED) so that moving to it rarely waits for the disk.
+ */
+struct trace_stream {
+    int fd;
+    size_t elem_size;
+    int64_t begin;
+    int64_t end;
+    int64_t chunk;
+    int64_t win_begin;  // entries [win_begin, win_end) are mapped
+    int64_t win_end;
+    char* map;          // mapping of the window, which starts at a page boundary
+    size_t map_len;
+    char* first;        // entry win_begin
+};
+
+void trace_stream_open(trace_stream* ts, string name, size_t elem_size, int64_t begin, int64_t end, int64_t chunk) {
+    ts->fd = open(name.c_str(), O_RDONLY);
+    if (ts->fd == -1) {
+        perror("Error opening file for reading");
+        exit(EXIT_FAILURE);
+    }
+    ts->elem_size = elem_size;
+    ts->begin = begin;
+    ts->end = end;
+    ts->chunk = chunk;
+    ts->win_begin = ts->win_end = 0;
+    ts->map = NULL;
+    ts->map_len = 0;
+}
+
+static void trace_stream_remap(trace_stream* ts, int64_t i) {
+    if (ts->map != NULL) munmap(ts->map, ts->map_len);
+
+    static const size_t page = sysconf(_SC_PAGESIZE);
+    ts->win_begin = ts->begin + (i - ts->begin) / ts->chunk * ts->chunk;
+    ts->win_end = std::min(ts->win_begin + ts->chunk, ts->end);
+    off_t off = ts->win_begin * ts->elem_size;
+    off_t map_off = off / page * page;
+    ts->map_len = (ts->win_end * ts->elem_size) - map_off;
+    ts->map = (char*) mmap(0, ts->map_len, PROT_READ, MAP_SHARED | MAP_POPULATE, ts->fd, map_off);
+    if (ts->map == MAP_FAILED) {
+        perror("Error mmapping the file");
+        exit(EXIT_FAILURE);
+    }
+    ts->first = ts->map + (off - map_off);
+
+    // start reading the next window
+    int64_t next_end = std::min(ts->win_end + ts->chunk, ts->end);
+    if (next_end > ts->win_end)
+        posix_fadvise(ts->fd, ts->win_end * ts->elem_size, (next_end - ts->win_end) * ts->elem_size, POSIX_FADV_WILLNEED);
+}
+
+// entry i of the file, for begin <= i < end
+static inline const void* trace_stream_get(trace_stream* ts, int64_t i) {
+    if (i < ts->win_begin || i >= ts->win_end) trace_stream_remap(ts, i);
+    return ts->first + (i - ts->win_begin) * ts->elem_size;
+}
+
+void trace_stream_close(trace_stream* ts) {
+    if (ts->map != NULL) munmap(ts->map, ts->map_len);
+    close(ts->fd);
+}
+
+/**
+ * Recorded traces: the exact operation stream of every thread of one phase,
+ * optionally with the time each operation was issued (ns since the start of
+ * the phase). Layout:
+ *   trace_header, int64_t counts[nthreads], padding to a whole operation
+ *   for each thread t: counts[t] operations
+ *   with TRACE_HAS_TIMESTAMPS, for each thread t: counts[t] uint64_t times
+ * Every section starts at a multiple of its entry size, so a section can be
+ * mapped as a slice of an array (see trace_stream).
+ */
+#define TRACE_MAGIC "SBTRACE1"
+#define TRACE_HAS_TIMESTAMPS 1
+
+struct trace_header {
+    char magic[8];
+    uint32_t nthreads;
+    uint32_t flags;
+};
+
+struct trace_layout {
+    int nthreads;
+    bool timestamps;
+    vector<int64_t> counts;
+    vector<int64_t> op_begin;   // index of the first operation of each thread, in operations
+    vector<int64_t> ts_begin;   // index of the first timestamp of each thread, in uint64_t
+};
+
+static int64_t trace_header_ops(int nthreads) {
+    size_t bytes = sizeof(trace_header) + nthreads * sizeof(int64_t);
+    return (bytes + sizeof(operation) - 1) / sizeof(operation);
+}
+
+static void trace_compute_layout(trace_layout* l) {
+    int64_t next = trace_header_ops(l->nthreads);
+    l->op_begin.resize(l->nthreads);
+    l->ts_begin.resize(l->nthreads);
+    for (int t = 0; t < l->nthreads; t++) {
+        l->op_begin[t] = next;
+        next += l->counts[t];
+    }
+    int64_t next_ts = next * sizeof(operation) / sizeof(uint64_t);
+    for (int t = 0; t < l->nthreads; t++) {
+        l->ts_begin[t] = next_ts;
+        next_ts += l->counts[t];
+    }
+}
+
+// does the file start like a recorded trace (rather than a plain operation array)?
+bool is_trace_file(string name) {
+    trace_header h;
+    int fd = open(name.c_str(), O_RDONLY);
+    if (fd == -1) return false;
+    bool result = read(fd, &h, sizeof(h)) == sizeof(h) && memcmp(h.magic, TRACE_MAGIC, 8) == 0;
+    close(fd);
+    return result;
+}
+
+trace_layout read_trace_layout(string name) {
+    trace_layout l;
+    trace_header h;
+    int fd = open(name.c_str(), O_RDONLY);
+    if (fd == -1 || read(fd, &h, sizeof(h)) != sizeof(h) || memcmp(h.magic, TRACE_MAGIC, 8) != 0) {
+        fprintf(stderr, "Error: %s is not a trace file\n", name.c_str());
+        exit(EXIT_FAILURE);
+    }
+    l.nthreads = h.nthreads;
+    l.timestamps = h.flags & TRACE_HAS_TIMESTAMPS;
+    l.counts.resize(l.nthreads);
+    if (read(fd, l.counts.data(), l.nthreads * sizeof(int64_t)) != (ssize_t) (l.nthreads * sizeof(int64_t))) {
+        fprintf(stderr, "Error: truncated trace header in %s\n", name.c_str());
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+    trace_compute_layout(&l);
+    return l;
+}
+
+static void write_or_die(FILE* f, const void* p, size_t bytes) {
+    if (bytes > 0 && fwrite(p, 1, bytes, f) != bytes) {
+        perror("Error writing trace file");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// writes the operations (and, if ts != NULL, the issue times) of nthreads threads
+void write_trace_file(string name, int nthreads, const vector<operation>* ops, const vector<uint64_t>* ts) {
+    FILE* f = fopen(name.c_str(), "wb");
+    if (f == NULL) {
+        perror("Error opening trace file for writing");
+        exit(EXIT_FAILURE);
+    }
+    trace_header h;
+    memcpy(h.magic, TRACE_MAGIC, 8);
+    h.nthreads = nthreads;
+    h.flags = (ts != NULL) ? TRACE_HAS_TIMESTAMPS : 0;
+    write_or_die(f, &h, sizeof(h));
+    for (int t = 0; t < nthreads; t++) {
+        int64_t n = ops[t].size();
+        write_or_die(f, &n, sizeof(n));
+    }
+    char zeros[sizeof(operation)] = {0};
+    write_or_die(f, zeros, trace_header_ops(nthreads) * sizeof(operation) - sizeof(h) - nthreads * sizeof(int64_t));
+    for (int t = 0; t < nthreads; t++)
+        write_or_die(f, ops[t].data(), ops[t].size() * sizeof(operation));
+    for (int t = 0; ts != NULL && t < nthreads; t++)
+        write_or_die(f, ts[t].data(), ts[t].size() * sizeof(uint64_t));
+    if (fclose(f) != 0) {
+        perror("Error closing trace file");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// writes the keys of nparts arrays, one after the other, as an i64 file (see read_i64_file)
+void write_i64_file(string name, const vector<int64_t>* parts, int nparts) {
+    FILE* f = fopen(name.c_str(), "wb");
+    if (f == NULL) {
+        perror("Error opening key file for writing");
+        exit(EXIT_FAILURE);
+    }
+    for (int t = 0; t < nparts; t++)
+        write_or_die(f, parts[t].data(), parts[t].size() * sizeof(int64_t));
+    if (fclose(f) != 0) {
+        perror("Error closing key file");
+        exit(EXIT_FAILURE);
+    }
+}
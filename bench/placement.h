@@ -0,0 +1,258 @@
+#pragma once
+
+/**
+ * Thread pinning and NUMA placement of the prefilled data structure.
+ *
+ * Pinning policies (-bind), turned into a CPU list for binding.h:
+ *   compact   fill one NUMA node before the next; within a node, one thread
+ *             per physical core first, then the remaining SMT siblings
+ *   scatter   round-robin over NUMA nodes, each in the compact order
+ *   <list>    an explicit list of CPUs and ranges, e.g. 0-7,16-23
+ * Thread tid runs on the (tid mod length)'th CPU of the list.
+ *
+ * Prefill memory policies (-prefill_mem, needs libnuma, see Makefile):
+ *   interleave  pages first touched during the prefill are interleaved over
+ *               all NUMA nodes
+ *   local       interleaved over the nodes that the pinned worker threads run
+ *               on only (so a one-socket run keeps the whole tree local)
+ * The policy is set on the main thread and inherited by the prefill threads
+ * it creates, and the default (first touch, local) is restored afterwards.
+ *
+ * The topology comes from sysfs, and the amount of memory the process has on
+ * each node from /proc/self/numa_maps, so pinning and reporting work without
+ * libnuma.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sched.h>
+#include <ctype.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "errors.h"
+#include "binding.h"
+
+#ifdef USE_LIBNUMA
+#include <numa.h>
+#endif
+
+#define PLACEMENT_PREFILL_DEFAULT 0
+#define PLACEMENT_PREFILL_INTERLEAVE 1
+#define PLACEMENT_PREFILL_LOCAL 2
+const char * const placement_prefill_mem_names[] = {"default", "interleave", "local"};
+
+struct placement_cpu_info {
+    int cpu;
+    int node;
+    int package;
+    int core;
+    int smt;    // index of this cpu among the SMT siblings of its core
+};
+
+std::string placement_policy = "none";
+int placement_prefill_mem = PLACEMENT_PREFILL_DEFAULT;
+std::vector<placement_cpu_info> placement_topology;
+int placement_thread_cpu[MAX_THREADS_POW2];
+
+// parses a CPU list in the sysfs format, e.g. "0-3,8,10-11" (dots also separate)
+static bool placement_parse_list(const std::string & s, std::vector<int> & cpus) {
+    size_t pos = 0;
+    while (pos < s.size()) {
+        size_t end = s.find_first_of(",.\n", pos);
+        if (end == std::string::npos) end = s.size();
+        std::string item = s.substr(pos, end - pos);
+        pos = end + 1;
+        if (item.empty()) continue;
+        char * rest;
+        long a = strtol(item.c_str(), &rest, 10);
+        long b = a;
+        if (*rest == '-') b = strtol(rest + 1, &rest, 10);
+        if (rest == item.c_str() || *rest != '\0' || a < 0 || b < a) return false;
+        for (long i = a; i <= b; i++) cpus.push_back((int) i);
+    }
+    return true;
+}
+
+static std::string placement_read_line(const std::string & path) {
+    std::ifstream f(path);
+    std::string line;
+    std::getline(f, line);
+    return line;
+}
+
+static int placement_read_int(const std::string & path, int dflt) {
+    std::string line = placement_read_line(path);
+    return line.empty() ? dflt : atoi(line.c_str());
+}
+
+// reads the online CPUs and their node, package and core from sysfs
+void placement_read_topology() {
+    std::vector<int> cpus;
+    placement_parse_list(placement_read_line("/sys/devices/system/cpu/online"), cpus);
+    std::map<int, int> node_of;
+    std::vector<int> nodes;
+    placement_parse_list(placement_read_line("/sys/devices/system/node/online"), nodes);
+    for (int node : nodes) {
+        std::vector<int> node_cpus;
+        placement_parse_list(placement_read_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"), node_cpus);
+        for (int cpu : node_cpus) node_of[cpu] = node;
+    }
+    std::map<std::pair<int, int>, int> siblings_seen;
+    placement_topology.clear();
+    for (int cpu : cpus) {
+        std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        placement_cpu_info info;
+        info.cpu = cpu;
+        info.node = node_of.count(cpu) ? node_of[cpu] : 0;
+        info.package = placement_read_int(dir + "physical_package_id", 0);
+        info.core = placement_read_int(dir + "core_id", cpu);
+        info.smt = siblings_seen[std::make_pair(info.package, info.core)]++;
+        placement_topology.push_back(info);
+    }
+}
+
+static int placement_node_of_cpu(int cpu) {
+    for (auto & info : placement_topology) if (info.cpu == cpu) return info.node;
+    return -1;
+}
+
+// CPUs in compact or scatter order
+static std::vector<int> placement_order(bool scatter) {
+    std::vector<placement_cpu_info> t = placement_topology;
+    std::sort(t.begin(), t.end(), [](const placement_cpu_info & a, const placement_cpu_info & b) {
+        if (a.node != b.node) return a.node < b.node;
+        if (a.smt != b.smt) return a.smt < b.smt;
+        if (a.package != b.package) return a.package < b.package;
+        if (a.core != b.core) return a.core < b.core;
+        return a.cpu < b.cpu;
+    });
+    std::vector<int> order;
+    if (!scatter) {
+        for (auto & info : t) order.push_back(info.cpu);
+        return order;
+    }
+    std::map<int, std::vector<int>> by_node;
+    for (auto & info : t) by_node[info.node].push_back(info.cpu);
+    for (size_t i = 0; order.size() < t.size(); i++) {
+        for (auto & node : by_node) {
+            if (i < node.second.size()) order.push_back(node.second[i]);
+        }
+    }
+    return order;
+}
+
+// selects the pinning policy. returns false if spec is not a policy or a valid
+// list of online CPUs.
+bool placement_set_policy(const char * spec) {
+    placement_read_topology();
+    std::vector<int> cpus;
+    if (strcmp(spec, "compact") == 0) cpus = placement_order(false);
+    else if (strcmp(spec, "scatter") == 0) cpus = placement_order(true);
+    else if (!placement_parse_list(spec, cpus)) return false;
+    if (cpus.empty() || (int) cpus.size() > LOGICAL_PROCESSORS) return false;
+    for (int cpu : cpus) {
+        if (cpu >= LOGICAL_PROCESSORS || placement_node_of_cpu(cpu) < 0) return false;
+    }
+    std::string list;
+    for (size_t i = 0; i < cpus.size(); i++) list += (i ? "." : "") + std::to_string(cpus[i]);
+    binding_parseCustom(list);
+    binding_configurePolicy(cpus.size());
+    placement_policy = spec;
+    return true;
+}
+
+bool placement_set_prefill_mem(const char * spec) {
+    if (strcmp(spec, "interleave") == 0) placement_prefill_mem = PLACEMENT_PREFILL_INTERLEAVE;
+    else if (strcmp(spec, "local") == 0) placement_prefill_mem = PLACEMENT_PREFILL_LOCAL;
+    else return false;
+    return true;
+}
+
+// every worker thread calls this first. pins the thread (if a policy is set)
+// and records where it runs.
+void placement_bind_thread(const int tid) {
+    binding_bindThread(tid);
+    placement_thread_cpu[tid] = sched_getcpu();
+}
+
+void placement_print_binding(const int nthreads) {
+    if (placement_topology.empty()) placement_read_topology();
+    std::cout << "binding=" << placement_policy << " thread_cpus:";
+    for (int tid = 0; tid < nthreads; tid++) {
+        int cpu = placement_thread_cpu[tid];
+        std::cout << " " << tid << ":cpu" << cpu << "/node" << placement_node_of_cpu(cpu);
+    }
+    std::cout << std::endl;
+    if (!binding_isInjectiveMapping(nthreads)) {
+        std::cout << "WARNING: more threads than CPUs in the binding, some CPUs run several threads" << std::endl;
+    }
+}
+
+// applies the prefill memory policy to the calling thread (and the threads it
+// creates from now on). nthreads pinned workers determine the "local" nodes.
+void placement_prefill_begin(const int nthreads) {
+    if (placement_prefill_mem == PLACEMENT_PREFILL_DEFAULT) return;
+#ifdef USE_LIBNUMA
+    if (numa_available() < 0) {
+        setbench_error("-prefill_mem needs NUMA support, but numa_available() failed");
+    }
+    struct bitmask * nodes = numa_allocate_nodemask();
+    if (placement_prefill_mem == PLACEMENT_PREFILL_INTERLEAVE) {
+        copy_bitmask_to_bitmask(numa_all_nodes_ptr, nodes);
+    }
+    else {
+        for (int tid = 0; tid < nthreads; tid++) {
+            numa_bitmask_setbit(nodes, placement_node_of_cpu(customBinding[tid % numCustomBindings]));
+        }
+    }
+    numa_set_interleave_mask(nodes);
+    numa_free_nodemask(nodes);
+#else
+    setbench_error("-prefill_mem needs libnuma (build with USE_LIBNUMA)");
+#endif
+}
+
+void placement_prefill_end() {
+    if (placement_prefill_mem == PLACEMENT_PREFILL_DEFAULT) return;
+#ifdef USE_LIBNUMA
+    numa_set_localalloc();
+#endif
+}
+
+// prints how much anonymous (heap, data structure) and file backed (mapped
+// datasets and traces) memory the process has on each NUMA node
+void placement_print_node_memory(const char * label) {
+    std::ifstream f("/proc/self/numa_maps");
+    if (!f) return;
+    std::map<int, double> anon_mb, file_mb;
+    std::string line;
+    while (std::getline(f, line)) {
+        std::istringstream tokens(line);
+        std::string token;
+        bool is_file = false;
+        double page_kb = 4;
+        std::map<int, long> pages;
+        while (tokens >> token) {
+            if (token.compare(0, 5, "file=") == 0) is_file = true;
+            else if (token.compare(0, 17, "kernelpagesize_kB") == 0) page_kb = atof(token.c_str() + 18);
+            else if (token.size() > 2 && token[0] == 'N' && isdigit(token[1])) {
+                size_t eq = token.find('=');
+                if (eq != std::string::npos) pages[atoi(token.c_str() + 1)] += atol(token.c_str() + eq + 1);
+            }
+        }
+        for (auto & p : pages) (is_file ? file_mb : anon_mb)[p.first] += p.second * page_kb / 1024;
+    }
+    std::cout << label << "_node_memory_mb anon:";
+    for (auto & p : anon_mb) std::cout << " N" << p.first << "=" << (uint64_t) p.second;
+    std::cout << " file:";
+    for (auto & p : file_mb) std::cout << " N" << p.first << "=" << (uint64_t) p.second;
+    std::cout << std::endl;
+}
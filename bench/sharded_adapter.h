@@ -0,0 +1,391 @@
+#pragma once
+
+/**
+ * Range-partitioned front-end over any ds_adapter.
+ *
+ * The key interval [lo, hi) is split into nshards equal ranges, each stored
+ * in an independent instance of the wrapped adapter, and every operation is
+ * routed to the instance that owns its key. Keys below lo go to the first
+ * shard and keys at or above hi to the last one. With lo = 0, hi = KEY_RANGE
+ * and nshards = -pim, shard boundaries coincide with the partitions of the
+ * hotspot key generator (zipf.h), so the shards model the PIM partitions.
+ *
+ * Each thread counts the operations it routes to every shard, and the time
+ * they take, in its own array of counters. printShardStats() merges them
+ * and reports how evenly load landed on the shards: max/mean and the Gini
+ * coefficient of operations, busy time and (where the wrapped adapter can
+ * iterate) stored keys per shard.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "errors.h"
+#include "plaf.h"
+#include "latency.h"
+
+struct shard_counter {
+    uint64_t ops;
+    uint64_t ticks;
+};
+
+// max/mean and Gini coefficient (0: perfectly even, 1: all load on one shard) of x
+static void shard_imbalance(std::vector<double> x, double * max_over_mean, double * gini) {
+    std::sort(x.begin(), x.end());
+    size_t n = x.size();
+    double sum = 0, weighted = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += x[i];
+        weighted += (i + 1) * x[i];
+    }
+    if (sum <= 0) {
+        *max_over_mean = 1;
+        *gini = 0;
+        return;
+    }
+    *max_over_mean = x[n - 1] / (sum / n);
+    *gini = 2 * weighted / (n * sum) - (double) (n + 1) / n;
+}
+
+template <class ADAPTER, typename K, typename V>
+class sharded_adapter {
+private:
+    const int nshards;
+    const K lo;
+    const K shardWidth;
+    ADAPTER ** const shards;
+    shard_counter * counters[MAX_THREADS_POW2];
+#ifdef DS_ADAPTER_SUPPORTS_BATCH
+    // a batch bucketed by shard (see bucket)
+    struct batch_scratch {
+        std::vector<int> start;
+        std::vector<int> next;
+        std::vector<int> order;
+        std::vector<K> keys;
+        std::vector<V> values;
+        PAD;
+    };
+    batch_scratch batchScratch[MAX_THREADS_POW2];
+#endif
+
+    inline int shardOf(const K& key) const {
+        if (key < lo) return 0;
+        K ix = (key - lo) / shardWidth;
+        return (ix < nshards) ? (int) ix : nshards - 1;
+    }
+
+    static void countKey(K key, V value, size_t * n) {
+        ++*n;
+    }
+
+    inline void count(const int tid, const int shard, const uint64_t t0) {
+        shard_counter * c = &counters[tid][shard];
+        ++c->ops;
+        c->ticks += lat_start() - t0;
+    }
+
+#ifdef DS_ADAPTER_SUPPORTS_BATCH
+    // counting sort of the n keys of a batch by shard: the keys of shard s end
+    // up at positions [start[s], start[s+1]) of the scratch keys of tid, in
+    // batch order, and order[j] is the index in the batch of the key at j
+    batch_scratch& bucket(const int tid, const K * const keys, const int n) {
+        batch_scratch& b = batchScratch[tid];
+        b.start.assign(nshards + 1, 0);
+        for (int i = 0; i < n; i++) b.start[shardOf(keys[i]) + 1]++;
+        for (int s = 0; s < nshards; s++) b.start[s + 1] += b.start[s];
+        b.next.assign(b.start.begin(), b.start.end() - 1);
+        b.order.resize(n);
+        b.keys.resize(n);
+        b.values.resize(n);
+        for (int i = 0; i < n; i++) {
+            int j = b.next[shardOf(keys[i])]++;
+            b.order[j] = i;
+            b.keys[j] = keys[i];
+        }
+        return b;
+    }
+#endif
+
+public:
+    sharded_adapter(const int NUM_THREADS,
+                    const K& KEY_ANY,
+                    const K& KEY_MAX,
+                    const V& NO_VALUE,
+                    Random64 * const rng,
+                    const int _nshards,
+                    const K& _lo,
+                    const K& _hi)
+    : nshards(_nshards)
+    , lo(_lo)
+    , shardWidth((_hi - _lo) / _nshards)
+    , shards(new ADAPTER * [_nshards])
+    {
+        if (nshards < 1 || shardWidth < 1) {
+            setbench_error("sharded_adapter needs at least one shard, and at most one shard per key");
+        }
+        for (int i = 0; i < nshards; i++) {
+            shards[i] = new ADAPTER(NUM_THREADS, KEY_ANY, KEY_MAX, NO_VALUE, rng);
+        }
+        memset(counters, 0, sizeof(counters));
+    }
+    ~sharded_adapter() {
+        for (int i = 0; i < nshards; i++) delete shards[i];
+        delete[] shards;
+        for (int tid = 0; tid < MAX_THREADS_POW2; tid++) free(counters[tid]);
+    }
+
+    V getNoValue() {
+        return (V) shards[0]->getNoValue();
+    }
+
+    // the thread allocates (first touch) its counters the first time it is initialized
+    void initThread(const int tid) {
+        if (counters[tid] == NULL) {
+            void * p;
+            if (posix_memalign(&p, PREFETCH_SIZE_BYTES, nshards * sizeof(shard_counter))) {
+                setbench_error("sharded_adapter: counter allocation failed");
+            }
+            memset(p, 0, nshards * sizeof(shard_counter));
+            counters[tid] = (shard_counter *) p;
+        }
+        for (int i = 0; i < nshards; i++) shards[i]->initThread(tid);
+    }
+    void deinitThread(const int tid) {
+        for (int i = 0; i < nshards; i++) shards[i]->deinitThread(tid);
+    }
+
+    bool contains(const int tid, const K& key) {
+        int s = shardOf(key);
+        uint64_t t0 = lat_start();
+        bool result = shards[s]->contains(tid, key);
+        count(tid, s, t0);
+        return result;
+    }
+    V insert(const int tid, const K& key, const V& val) {
+        int s = shardOf(key);
+        uint64_t t0 = lat_start();
+        V result = shards[s]->insert(tid, key, val);
+        count(tid, s, t0);
+        return result;
+    }
+    V insertIfAbsent(const int tid, const K& key, const V& val) {
+        int s = shardOf(key);
+        uint64_t t0 = lat_start();
+        V result = shards[s]->insertIfAbsent(tid, key, val);
+        count(tid, s, t0);
+        return result;
+    }
+    V erase(const int tid, const K& key) {
+        int s = shardOf(key);
+        uint64_t t0 = lat_start();
+        V result = shards[s]->erase(tid, key);
+        count(tid, s, t0);
+        return result;
+    }
+    V find(const int tid, const K& key) {
+        int s = shardOf(key);
+        uint64_t t0 = lat_start();
+        V result = shards[s]->find(tid, key);
+        count(tid, s, t0);
+        return result;
+    }
+    // queries every shard that overlaps [lo, hi) in key order, and concatenates
+    // the results, until capacity keys are returned. atomic per shard only.
+    int rangeQuery(const int tid, const K& rqlo, const K& rqhi, K * const resultKeys, V * const resultValues, const int capacity) {
+        int size = 0;
+        for (int s = shardOf(rqlo); s <= shardOf(rqhi) && size < capacity; s++) {
+            uint64_t t0 = lat_start();
+            size += shards[s]->rangeQuery(tid, rqlo, rqhi, resultKeys + size, resultValues + size, capacity - size);
+            count(tid, s, t0);
+        }
+        return size;
+    }
+#ifdef DS_ADAPTER_SUPPORTS_ORDERED_SEARCH
+    // look in the shard of key, then in the shards before it (predecessor) or
+    // after it (successor, lowerBound) until one has an answer. atomic per shard only.
+    V predecessor(const int tid, const K& key, K * const outKey) {
+        V result = getNoValue();
+        for (int s = shardOf(key); s >= 0 && result == getNoValue(); s--) {
+            uint64_t t0 = lat_start();
+            result = shards[s]->predecessor(tid, key, outKey);
+            count(tid, s, t0);
+        }
+        return result;
+    }
+    V successor(const int tid, const K& key, K * const outKey) {
+        V result = getNoValue();
+        for (int s = shardOf(key); s < nshards && result == getNoValue(); s++) {
+            uint64_t t0 = lat_start();
+            result = shards[s]->successor(tid, key, outKey);
+            count(tid, s, t0);
+        }
+        return result;
+    }
+    V lowerBound(const int tid, const K& key, K * const outKey) {
+        V result = getNoValue();
+        for (int s = shardOf(key); s < nshards && result == getNoValue(); s++) {
+            uint64_t t0 = lat_start();
+            result = shards[s]->lowerBound(tid, key, outKey);
+            count(tid, s, t0);
+        }
+        return result;
+    }
+#endif
+#ifdef DS_ADAPTER_SUPPORTS_BATCH
+    // bucket the batch by shard, and pass each shard its keys as one batch.
+    // findBatch writes the values back in the order of the caller's keys.
+    int insertBatch(const int tid, const K * const keys, const V * const values, const int n) {
+        batch_scratch& b = bucket(tid, keys, n);
+        for (int j = 0; j < n; j++) b.values[j] = values[b.order[j]];
+        int result = 0;
+        for (int s = 0; s < nshards; s++) {
+            int i = b.start[s];
+            if (i == b.start[s + 1]) continue;
+            uint64_t t0 = lat_start();
+            result += shards[s]->insertBatch(tid, &b.keys[i], &b.values[i], b.start[s + 1] - i);
+            count(tid, s, t0);
+        }
+        return result;
+    }
+    int findBatch(const int tid, const K * const keys, const int n, V * const values) {
+        batch_scratch& b = bucket(tid, keys, n);
+        int result = 0;
+        for (int s = 0; s < nshards; s++) {
+            int i = b.start[s];
+            if (i == b.start[s + 1]) continue;
+            uint64_t t0 = lat_start();
+            result += shards[s]->findBatch(tid, &b.keys[i], b.start[s + 1] - i, &b.values[i]);
+            count(tid, s, t0);
+        }
+        for (int j = 0; j < n; j++) values[b.order[j]] = b.values[j];
+        return result;
+    }
+#endif
+    // splits the n strictly increasing keys by shard, and bulk loads the shards
+    // in parallel, each with one thread.
+    void bulkLoad(const int numThreads, const K * const keys, const V * const values, const size_t n, const double fillFactor) {
+        std::vector<size_t> bounds(nshards + 1);
+        bounds[0] = 0;
+        for (int s = 1; s < nshards; s++) {
+            bounds[s] = std::lower_bound(keys, keys + n, (K) (lo + s * shardWidth)) - keys;
+        }
+        bounds[nshards] = n;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < numThreads; t++) {
+            threads.emplace_back([=, &bounds]() {
+                for (int s = t; s < nshards; s += numThreads) {
+                    size_t first = bounds[s];
+                    if (bounds[s + 1] > first) {
+                        shards[s]->bulkLoad(1, keys + first, values + first, bounds[s + 1] - first, fillFactor);
+                    }
+                }
+            });
+        }
+        for (auto & t : threads) t.join();
+    }
+
+    void printSummary() {
+        for (int i = 0; i < nshards; i++) shards[i]->printSummary();
+    }
+    bool validateStructure() {
+        for (int i = 0; i < nshards; i++) {
+            if (!shards[i]->validateStructure()) return false;
+        }
+        return true;
+    }
+    void printObjectSizes() {
+        shards[0]->printObjectSizes();
+    }
+    // try to clean up: must only be called by a single thread as part of the test harness!
+    void debugGCSingleThreaded() {
+        for (int i = 0; i < nshards; i++) shards[i]->debugGCSingleThreaded();
+    }
+
+    size_t size() {
+        size_t result = 0;
+        for (int i = 0; i < nshards; i++) result += shards[i]->size();
+        return result;
+    }
+
+#ifdef DS_ADAPTER_SUPPORTS_MEMORY_STATS
+    // summed over the shards (every shard has its own record manager)
+    void getMemoryStats(size_t * const nodeBytes, long long * const outstanding, long long * const limbo, long long * const freed) {
+        *outstanding = 0;
+        *limbo = 0;
+        *freed = 0;
+        for (int i = 0; i < nshards; i++) {
+            long long o, l, f;
+            shards[i]->getMemoryStats(nodeBytes, &o, &l, &f);
+            *outstanding += o;
+            *limbo += l;
+            *freed += f;
+        }
+    }
+#endif
+
+    int getNumShards() {
+        return nshards;
+    }
+
+    // zeroes the per-shard counters. must not run concurrently with operations.
+    void resetShardStats() {
+        for (int tid = 0; tid < MAX_THREADS_POW2; tid++) {
+            if (counters[tid] != NULL) memset(counters[tid], 0, nshards * sizeof(shard_counter));
+        }
+    }
+
+    // prints the load imbalance over shards since the last reset, the hottest
+    // shards, and the per-shard operation counts. must not run concurrently
+    // with operations.
+    void printShardStats() {
+        std::vector<double> ops(nshards, 0), busy_ns(nshards, 0), keys(nshards, 0);
+        for (int tid = 0; tid < MAX_THREADS_POW2; tid++) {
+            if (counters[tid] == NULL) continue;
+            for (int s = 0; s < nshards; s++) {
+                ops[s] += counters[tid][s].ops;
+                busy_ns[s] += counters[tid][s].ticks / lat_ticks_per_ns;
+            }
+        }
+#ifdef DS_ADAPTER_SUPPORTS_TERMINAL_ITERATE
+        for (int s = 0; s < nshards; s++) {
+            size_t n = 0;
+            shards[s]->iterate(countKey, &n);
+            keys[s] = n;
+        }
+#endif
+
+        double max_over_mean, gini;
+        std::cout << "shards=" << nshards;
+        shard_imbalance(ops, &max_over_mean, &gini);
+        std::cout << " shard_ops_max_over_mean=" << max_over_mean << " shard_ops_gini=" << gini;
+        shard_imbalance(busy_ns, &max_over_mean, &gini);
+        std::cout << " shard_time_max_over_mean=" << max_over_mean << " shard_time_gini=" << gini;
+#ifdef DS_ADAPTER_SUPPORTS_TERMINAL_ITERATE
+        shard_imbalance(keys, &max_over_mean, &gini);
+        std::cout << " shard_keys_max_over_mean=" << max_over_mean << " shard_keys_gini=" << gini;
+#endif
+        std::cout << std::endl;
+
+        std::vector<int> order(nshards);
+        for (int s = 0; s < nshards; s++) order[s] = s;
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return ops[a] > ops[b]; });
+        double total = 0;
+        for (int s = 0; s < nshards; s++) total += ops[s];
+        std::cout << "shard_hottest:";
+        for (int i = 0; i < std::min(nshards, 8) && total > 0; i++) {
+            int s = order[i];
+            std::cout << " " << s << ":ops=" << (uint64_t) ops[s] << ",share=" << ops[s] / total
+                      << ",avg_ns=" << (ops[s] > 0 ? busy_ns[s] / ops[s] : 0);
+        }
+        std::cout << std::endl;
+
+        std::cout << "shard_ops:";
+        for (int s = 0; s < nshards; s++) std::cout << " " << (uint64_t) ops[s];
+        std::cout << std::endl;
+    }
+};
@@ -0,0 +1,196 @@
+#pragma once
+
+/**
+ * Variable-length keys (strings or arbitrary byte slices) for data
+ * structures that store keys by value, like the (a,b)-tree.
+ *
+ * A str_key is 16 bytes: a pointer to the full key, which is kept (after a
+ * 4-byte length) in a str_key_arena that outlives the data structure, and an
+ * inline prefix of 8 key bytes, packed big-endian into an integer so that
+ * comparing prefixes compares the bytes. Comparisons look at the inline
+ * prefixes first, and only follow the pointers to compare the full keys
+ * when the prefixes are equal. Inner nodes and leaves therefore resolve
+ * most comparisons without touching key memory.
+ *
+ * Real key sets often start with the same bytes ("https://www."), which
+ * would make every prefix equal. The prefix is therefore taken after the
+ * longest prefix common to all keys of the arena (str_key_skip), which still
+ * orders keys correctly as long as every key compared shares those bytes.
+ * That holds in the driver, whose keys all come from one arena.
+ *
+ * Key formats (-keys), generated for record r like ycsb_key(r), so that
+ * consecutive records are scattered over the key order:
+ *   url        "https://www.site<n>.com/<category>/<id>", 35-55 bytes
+ *   composite  16 binary bytes: big-endian tenant (32 bits), user (64 bits)
+ *              and sequence number (32 bits), like a composite primary key
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "zipf.h"
+
+#define STR_KEYS_NONE 0
+#define STR_KEYS_URL 1
+#define STR_KEYS_COMPOSITE 2
+const char * const str_key_format_names[] = {"int", "url", "composite"};
+
+int str_key_format = STR_KEYS_NONE;
+int str_key_skip = 0;   // bytes common to all keys, not part of the inline prefix
+
+struct str_key {
+    uint64_t prefix;    // key bytes [str_key_skip, str_key_skip + 8), big-endian, zero padded
+    const char * bytes; // the full key, preceded by its uint32_t length; NULL for the empty key
+
+    inline uint32_t length() const {
+        uint32_t len = 0;
+        if (bytes != NULL) memcpy(&len, bytes - sizeof(uint32_t), sizeof(uint32_t));
+        return len;
+    }
+};
+
+static inline uint64_t str_key_make_prefix(const char * bytes, uint32_t len) {
+    uint64_t prefix = 0;
+    for (int i = 0; i < 8; i++) {
+        uint32_t pos = str_key_skip + i;
+        prefix = (prefix << 8) | ((pos < len) ? (uint8_t) bytes[pos] : 0);
+    }
+    return prefix;
+}
+
+// compares the full keys (memcmp order, a proper prefix of a key sorts before it)
+static inline int str_key_compare_full(const str_key & a, const str_key & b) {
+    if (a.bytes == b.bytes) return 0;
+    uint32_t la = a.length(), lb = b.length();
+    int c = memcmp(a.bytes, b.bytes, std::min(la, lb));
+    if (c != 0) return c;
+    return (la < lb) ? -1 : (la > lb);
+}
+
+inline bool operator<(const str_key & a, const str_key & b) {
+    if (a.prefix != b.prefix) return a.prefix < b.prefix;
+    return str_key_compare_full(a, b) < 0;
+}
+
+inline bool operator==(const str_key & a, const str_key & b) {
+    return a.prefix == b.prefix && str_key_compare_full(a, b) == 0;
+}
+
+inline bool operator!=(const str_key & a, const str_key & b) {
+    return !(a == b);
+}
+
+bool str_key_parse_format(const char * name) {
+    for (int i = 0; i < 3; i++) {
+        if (strcmp(name, str_key_format_names[i]) == 0) {
+            str_key_format = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// writes the key of record r in the selected format to buf (at least 64 bytes), returns its length
+static uint32_t str_key_generate(uint64_t r, char * buf) {
+    static const char * const categories[] = {"news", "shop/item", "video", "user/profile", "wiki", "search", "images", "docs/api"};
+    uint64_t h = mix(r);
+    if (str_key_format == STR_KEYS_URL) {
+        // h is a bijection of r, so every record gets a distinct id
+        return snprintf(buf, 64, "https://www.site%u.com/%s/%llu", (unsigned) (mix(h) % 1000),
+                        categories[(h >> 10) % 8], (unsigned long long) h);
+    }
+    uint32_t tenant = (uint32_t) (mix(h) % 4096);
+    uint32_t seq = (uint32_t) r;
+    for (int i = 0; i < 4; i++) buf[i] = (char) (tenant >> (24 - 8 * i));
+    for (int i = 0; i < 8; i++) buf[4 + i] = (char) (h >> (56 - 8 * i));
+    for (int i = 0; i < 4; i++) buf[12 + i] = (char) (seq >> (24 - 8 * i));
+    return 16;
+}
+
+/**
+ * The keys of records [0, n), generated by nthreads threads. Each thread
+ * writes the keys of a slice of the records into its own buffer.
+ */
+struct str_key_arena {
+    int64_t n;
+    str_key * keys;
+    std::vector<std::vector<char>> buffers;
+    uint64_t bytes;
+};
+
+void str_key_arena_build(str_key_arena * arena, int64_t n, const int nthreads) {
+    arena->n = n;
+    arena->keys = new str_key[n];
+    arena->buffers.assign(nthreads, std::vector<char>());
+    std::vector<int> lcp(nthreads, 64);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nthreads; t++) {
+        threads.emplace_back([=, &lcp]() {
+            int64_t begin = n * t / nthreads, end = n * (t + 1) / nthreads;
+            std::vector<char> & buf = arena->buffers[t];
+            std::vector<uint64_t> offsets;
+            char key[64], first[64];
+            for (int64_t r = begin; r < end; r++) {
+                uint32_t len = str_key_generate(r, key);
+                if (r == begin) {
+                    memcpy(first, key, len);
+                    lcp[t] = len;
+                }
+                int common = 0;
+                while (common < lcp[t] && common < (int) len && key[common] == first[common]) common++;
+                lcp[t] = std::min(lcp[t], common);
+                offsets.push_back(buf.size() + sizeof(uint32_t));
+                buf.insert(buf.end(), (char *) &len, (char *) &len + sizeof(uint32_t));
+                buf.insert(buf.end(), key, key + len);
+            }
+            for (int64_t r = begin; r < end; r++) arena->keys[r].bytes = buf.data() + offsets[r - begin];
+        });
+    }
+    for (auto & t : threads) t.join();
+
+    // the common prefix of all keys: the shortest of the slices' common prefixes,
+    // cut where the first keys of the slices differ
+    int skip = 64;
+    for (int t = 0; t < nthreads; t++) {
+        if (n * t / nthreads == n * (t + 1) / nthreads) continue;
+        const str_key & k = arena->keys[n * t / nthreads];
+        const str_key & k0 = arena->keys[0];
+        int common = 0;
+        while (common < lcp[t] && common < (int) std::min(k.length(), k0.length()) && k.bytes[common] == k0.bytes[common]) common++;
+        skip = std::min(skip, common);
+    }
+    str_key_skip = (n > 1) ? skip : 0;
+
+    threads.clear();
+    for (int t = 0; t < nthreads; t++) {
+        threads.emplace_back([=]() {
+            for (int64_t r = n * t / nthreads; r < n * (t + 1) / nthreads; r++) {
+                str_key & k = arena->keys[r];
+                k.prefix = str_key_make_prefix(k.bytes, k.length());
+            }
+        });
+    }
+    for (auto & t : threads) t.join();
+
+    arena->bytes = n * sizeof(str_key);
+    for (auto & b : arena->buffers) arena->bytes += b.size();
+}
+
+void str_key_arena_free(str_key_arena * arena) {
+    delete[] arena->keys;
+    arena->keys = NULL;
+    arena->buffers.clear();
+}
+
+void str_key_arena_print(const str_key_arena * arena) {
+    uint64_t chars = 0;
+    for (int64_t r = 0; r < arena->n; r++) chars += arena->keys[r].length();
+    std::cout << "keys=" << str_key_format_names[str_key_format] << " records=" << arena->n
+              << " avg_key_bytes=" << (arena->n ? (double) chars / arena->n : 0)
+              << " common_prefix_bytes=" << str_key_skip << " arena_mb=" << arena->bytes / (1024.0 * 1024) << std::endl;
+}
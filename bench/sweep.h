@@ -0,0 +1,223 @@
+#pragma once
+
+/**
+ * Thread count sweeps (-sweep) and machine-readable results (-results).
+ *
+ * -sweep runs the measured phases once per thread count: 1, 2, 4, ... and
+ * N itself (-sweep N, or -sweep max for all online CPUs, at most
+ * MAX_THREADS_POW2), or the counts of an explicit list (-sweep 1,8,24,48).
+ * -sweep_smt adds the points where the threads start to share physical
+ * cores or to spill to the next NUMA node: the number of physical cores of
+ * the first node, the first two nodes, ..., and (with -bind compact, which
+ * it selects if no -bind is given, so the threads fill the cores of a node
+ * before their SMT siblings) the CPUs of each node. By default, one data
+ * structure prefilled by the largest thread count serves every point. With
+ * -sweep_rebuild each point constructs and prefills its own, which keeps
+ * the points comparable when the workload grows or shrinks the data
+ * structure.
+ *
+ * -results <path> writes a row per measured phase, as CSV with a header, or
+ * a JSON object per line if path ends in .json or .jsonl: the configuration
+ * (see results_set), the phase, thread count and offered rate, operations,
+ * throughput, overall latency percentiles, and every counted hardware event
+ * per operation. Rows are flushed as they are written, so an interrupted
+ * sweep keeps the points it finished. After a sweep, sweep_print_summary
+ * prints the throughput and speedup of each point per phase.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "placement.h"
+#include "papi_exp.h"
+#include "latency.h"
+#include "timed_run.h"
+#include "open_loop.h"
+
+const char * sweep_spec = NULL;
+bool sweep_smt = false;
+bool sweep_rebuild = false;
+std::vector<int> sweep_threads;     // in increasing order
+
+const char * results_path = NULL;
+FILE * results_file = NULL;
+bool results_json = false;
+struct results_column {
+    std::string name;
+    std::string value;
+    bool numeric;       // written unquoted in JSON
+};
+std::vector<results_column> results_config;
+
+struct sweep_point {
+    std::string phase;
+    int nthreads;
+    double mops;
+    uint64_t p99_ns;
+};
+std::vector<sweep_point> sweep_points;
+
+// adds a configuration column to every row (call before the first phase).
+// a numeric value must be a number already formatted as such (e.g., by std::to_string).
+void results_set(const std::string & name, const std::string & value, bool numeric = false) {
+    results_config.push_back({name, value, numeric});
+}
+
+// turns the -sweep spec (or, without one, nthreads) into the list of thread
+// counts. returns false if the spec is invalid or a count is outside [1, max_threads].
+bool sweep_init(int nthreads, int max_threads) {
+    sweep_threads.clear();
+    if (sweep_spec == NULL) {
+        sweep_threads.push_back(nthreads);
+        return true;
+    }
+    if (placement_topology.empty()) placement_read_topology();
+    std::vector<int> counts;
+    if (strchr(sweep_spec, ',') != NULL) {
+        if (!placement_parse_list(sweep_spec, counts)) return false;
+    }
+    else {
+        int n = (strcmp(sweep_spec, "max") == 0) ? std::min((int) placement_topology.size(), max_threads) : atoi(sweep_spec);
+        if (n < 1) return false;
+        for (int t = 1; t < n; t *= 2) counts.push_back(t);
+        counts.push_back(n);
+    }
+    if (counts.empty()) return false;
+    int largest = *std::max_element(counts.begin(), counts.end());
+    if (sweep_smt) {
+        std::map<int, int> cores, cpus;     // per node
+        for (auto & info : placement_topology) {
+            if (info.smt == 0) cores[info.node]++;
+            cpus[info.node]++;
+        }
+        int before = 0;
+        for (auto & node : cores) {
+            int t = before + node.second;
+            if (t <= largest) counts.push_back(t);
+            before += cpus[node.first];
+            if (before <= largest) counts.push_back(before);
+        }
+    }
+    std::sort(counts.begin(), counts.end());
+    counts.erase(std::unique(counts.begin(), counts.end()), counts.end());
+    if (counts.front() < 1 || counts.back() > max_threads) return false;
+    sweep_threads = counts;
+    return true;
+}
+
+// the thread counts to run the phases of a data structure built with nthreads threads
+std::vector<int> sweep_phase_threads(int nthreads) {
+    if (sweep_spec == NULL || sweep_rebuild) return std::vector<int>(1, nthreads);
+    return sweep_threads;
+}
+
+// value with every quote, and (in JSON) backslash, escaped
+static std::string results_escape(const std::string & value) {
+    std::string out;
+    for (char c : value) {
+        if (c == '"') out += results_json ? "\\\"" : "\"\"";
+        else if (c == '\\' && results_json) out += "\\\\";
+        else out += c;
+    }
+    return out;
+}
+
+static void results_field(bool first, const std::string & name, const std::string & value, bool quote) {
+    if (results_json) {
+        fprintf(results_file, "%s\"%s\":", first ? "{" : ",", name.c_str());
+        if (quote) fprintf(results_file, "\"%s\"", results_escape(value).c_str());
+        else fprintf(results_file, "%s", value.c_str());
+    }
+    else if (value.find_first_of(",\"") != std::string::npos) fprintf(results_file, "%s\"%s\"", first ? "" : ",", results_escape(value).c_str());
+    else fprintf(results_file, "%s%s", first ? "" : ",", value.c_str());
+}
+
+static std::string results_number(double x) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.6g", x);
+    return buf;
+}
+
+// the columns of a row after the configuration, and their values for the phase that just ended
+static std::vector<std::pair<std::string, std::string>> results_columns(const char * phase, int tnum) {
+    std::vector<std::pair<std::string, std::string>> cols;
+    uint64_t ops = exp_phase_ops(tnum);
+    cols.push_back(std::make_pair("phase", phase));
+    cols.push_back(std::make_pair("nthreads", std::to_string(tnum)));
+    cols.push_back(std::make_pair("rate_mops", results_number(openloop_rate)));
+    cols.push_back(std::make_pair("ops", std::to_string(ops)));
+    cols.push_back(std::make_pair("elapsed_ms", results_number((exp_end_ns - exp_start_ns) / 1e6)));
+    cols.push_back(std::make_pair("throughput_mops", results_number(exp_phase_throughput(tnum))));
+    cols.push_back(std::make_pair("p50_ns", std::to_string(lat_overall_percentile_ns(tnum, 50))));
+    cols.push_back(std::make_pair("p90_ns", std::to_string(lat_overall_percentile_ns(tnum, 90))));
+    cols.push_back(std::make_pair("p99_ns", std::to_string(lat_overall_percentile_ns(tnum, 99))));
+    cols.push_back(std::make_pair("p99.9_ns", std::to_string(lat_overall_percentile_ns(tnum, 99.9))));
+    for (int j = 0; j < papi_num_events; j++) {
+        long long total = 0;
+        for (int i = 0; i < tnum; i++) if (papi_values[i] != NULL) total += papi_values[i][j];
+        cols.push_back(std::make_pair(papi_event_names[j] + "_per_op", results_number(ops > 0 ? (double) total / ops : 0)));
+    }
+    return cols;
+}
+
+// records the phase that tnum threads just finished: writes its row to -results,
+// and keeps its throughput for sweep_print_summary
+void sweep_phase_done(const char * phase, int tnum) {
+    if (sweep_spec != NULL) {
+        sweep_point p = {phase, tnum, exp_phase_throughput(tnum), lat_overall_percentile_ns(tnum, 99)};
+        sweep_points.push_back(p);
+    }
+    if (results_path == NULL) return;
+
+    std::vector<std::pair<std::string, std::string>> cols = results_columns(phase, tnum);
+    if (results_file == NULL) {
+        size_t len = strlen(results_path);
+        results_json = (len >= 5 && strcmp(results_path + len - 5, ".json") == 0)
+                    || (len >= 6 && strcmp(results_path + len - 6, ".jsonl") == 0);
+        results_file = fopen(results_path, "w");
+        if (results_file == NULL) {
+            printf("could not write -results %s\n", results_path);
+            exit(1);
+        }
+        if (!results_json) {
+            for (size_t i = 0; i < results_config.size(); i++) results_field(i == 0, results_config[i].name, results_config[i].name, false);
+            for (size_t i = 0; i < cols.size(); i++) results_field(results_config.empty() && i == 0, cols[i].first, cols[i].first, false);
+            fprintf(results_file, "\n");
+        }
+    }
+    for (size_t i = 0; i < results_config.size(); i++) results_field(i == 0, results_config[i].name, results_config[i].value, !results_config[i].numeric);
+    for (size_t i = 0; i < cols.size(); i++) results_field(results_config.empty() && i == 0, cols[i].first, cols[i].second, i == 0);
+    fprintf(results_file, results_json ? "}\n" : "\n");
+    fflush(results_file);
+}
+
+// prints the throughput of every point of the sweep per phase, with the
+// speedup over the first point and the p99 latency
+void sweep_print_summary() {
+    if (sweep_spec == NULL) return;
+    std::vector<std::string> phases;
+    for (auto & p : sweep_points)
+        if (std::find(phases.begin(), phases.end(), p.phase) == phases.end()) phases.push_back(p.phase);
+    for (auto & phase : phases) {
+        double base = 0;
+        std::cout << "Sweep_" << phase << " nthreads:Mops/s(speedup,p99_ns):";
+        for (auto & p : sweep_points) {
+            if (p.phase != phase) continue;
+            if (base <= 0) base = p.mops;
+            std::cout << " " << p.nthreads << ":" << p.mops << "(" << (base > 0 ? p.mops / base : 0) << "," << p.p99_ns << ")";
+        }
+        std::cout << std::endl;
+    }
+}
+
+void results_close() {
+    if (results_file != NULL) fclose(results_file);
+    results_file = NULL;
+}
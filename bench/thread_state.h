@@ -0,0 +1,42 @@
+#pragma once
+
+/**
+ * Per-thread state of the benchmark harness.
+ *
+ * Per-thread arrays of the harness (operation counters, latency histograms,
+ * hardware event values, random generators, ...) are indexed by thread id
+ * and have room for MAX_THREADS_POW2 threads, the limit the data structures
+ * and record managers are built for (see the Makefile). thread_state_check
+ * rejects a larger id when a thread sets up, instead of letting it write
+ * past the end of an array.
+ *
+ * State larger than a few counters is not kept in the arrays themselves:
+ * they hold one pointer per thread, and thread_state_alloc allocates the
+ * thread's block the first time the thread needs it. Memory therefore grows
+ * with the number of threads that actually run, and each block is first
+ * touched by (and placed on the NUMA node of) its thread. Blocks are aligned
+ * and padded to PREFETCH_SIZE_BYTES, so no two threads share a cache line.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "errors.h"
+#include "plaf.h"
+
+static inline void thread_state_check(int tid, const char * who) {
+    if (tid < 0 || tid >= MAX_THREADS_POW2) {
+        setbench_error(who << ": thread id " << tid << " is outside [0, " << MAX_THREADS_POW2 << "); rebuild with a larger MAX_THREADS_POW2");
+    }
+}
+
+// a zeroed block of at least bytes, cache line aligned and padded
+void * thread_state_alloc(size_t bytes) {
+    size_t padded = (bytes + PREFETCH_SIZE_BYTES - 1) / PREFETCH_SIZE_BYTES * PREFETCH_SIZE_BYTES;
+    void * p;
+    if (posix_memalign(&p, PREFETCH_SIZE_BYTES, padded)) {
+        setbench_error("per-thread allocation of " << padded << " bytes failed");
+    }
+    memset(p, 0, padded);
+    return p;
+}
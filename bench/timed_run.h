@@ -0,0 +1,172 @@
+#pragma once
+
+/**
+ * Coordination of the measured phases: a shared start barrier, a stop flag,
+ * per-thread operation counters, and a time series of aggregate throughput.
+ *
+ * A phase either executes a fixed number of operations per thread
+ * (exp_duration_ms == 0), or runs every thread until the main thread raises
+ * the stop flag after exp_duration_ms milliseconds. In both modes throughput
+ * is computed from wall time, measured from the moment all threads are
+ * released from the start barrier until the last one finishes.
+ *
+ * Usage:
+ *   main thread:  exp_phase_reset(); create workers; exp_phase_run(tnum);
+ *                 join workers; exp_phase_print(tnum);
+ *   worker tid:   per-thread setup; exp_thread_ready(tid);
+ *                 for (i = 0; exp_keep_running(i, n); i++) { ...; exp_count_op(tid); }
+ *                 exp_thread_done(tid); per-thread teardown;
+ */
+
+#include <stdint.h>
+#include <time.h>
+#include <vector>
+#include <iostream>
+
+#include "plaf.h"
+#include "thread_state.h"
+
+struct exp_thread_counter {
+    volatile uint64_t ops;
+    uint64_t end_ns;
+    char pad[PREFETCH_SIZE_BYTES - 2 * sizeof(uint64_t)];
+};
+
+PAD;
+volatile int exp_ready_threads = 0;
+volatile int exp_done_threads = 0;
+PAD;
+volatile bool exp_start = false;
+PAD;
+volatile bool exp_stop = false;
+volatile int exp_batch = 0;
+PAD;
+exp_thread_counter exp_counters[MAX_THREADS_POW2];
+
+double exp_duration_ms = 0;
+int exp_interval_ms = 100;
+int exp_num_batches = 1;
+
+uint64_t exp_start_ns;
+uint64_t exp_end_ns;
+std::vector<std::pair<uint64_t, uint64_t>> exp_samples; // (time, aggregate ops completed) at the end of each interval
+// if set, called by the main thread right after each sample, with its time (e.g., mem_accountant.h)
+void (*exp_sample_hook)(uint64_t now_ns) = NULL;
+
+static uint64_t exp_now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline bool exp_keep_running(int64_t i, int64_t n) {
+    return exp_duration_ms > 0 ? !exp_stop : i < n;
+}
+
+// index of the key distribution batch that operation i of n should draw from.
+// in timed mode, batches advance with elapsed time (at sampling granularity).
+static inline int exp_batch_index(int64_t i, int64_t n) {
+    return exp_duration_ms > 0 ? exp_batch : i * exp_num_batches / n;
+}
+
+static inline void exp_count_op(int tid) {
+    exp_counters[tid].ops = exp_counters[tid].ops + 1;
+}
+
+static inline void exp_count_ops(int tid, int64_t n) {
+    exp_counters[tid].ops = exp_counters[tid].ops + n;
+}
+
+void exp_thread_ready(int tid) {
+    thread_state_check(tid, "exp_thread_ready");
+    exp_counters[tid].ops = 0;
+    __sync_fetch_and_add(&exp_ready_threads, 1);
+    while (!exp_start) {}
+}
+
+void exp_thread_done(int tid) {
+    exp_counters[tid].end_ns = exp_now_ns();
+    __sync_fetch_and_add(&exp_done_threads, 1);
+}
+
+void exp_phase_reset(int num_batches) {
+    exp_ready_threads = 0;
+    exp_done_threads = 0;
+    exp_start = false;
+    exp_stop = false;
+    exp_batch = 0;
+    exp_num_batches = num_batches;
+    exp_samples.clear();
+}
+
+static uint64_t exp_total_ops(int tnum) {
+    uint64_t total = 0;
+    for (int tid = 0; tid < tnum; tid++) total += exp_counters[tid].ops;
+    return total;
+}
+
+// releases the workers once all tnum of them are ready, then samples aggregate
+// throughput every exp_interval_ms until the phase ends.
+void exp_phase_run(int tnum) {
+    while (exp_ready_threads < tnum) {}
+    exp_start_ns = exp_now_ns();
+    SOFTWARE_BARRIER;
+    exp_start = true;
+
+    uint64_t interval_ns = exp_interval_ms * 1000000ULL;
+    uint64_t duration_ns = exp_duration_ms * 1000000ULL;
+    uint64_t next = exp_start_ns;
+    while (exp_done_threads < tnum) {
+        next += interval_ns;
+        if (duration_ns > 0 && next > exp_start_ns + duration_ns) next = exp_start_ns + duration_ns;
+        timespec ts = {(time_t) (next / 1000000000ULL), (long) (next % 1000000000ULL)};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        exp_samples.push_back(std::make_pair(next, exp_total_ops(tnum)));
+        if (exp_sample_hook != NULL) exp_sample_hook(next);
+
+        uint64_t elapsed = next - exp_start_ns;
+        if (duration_ns > 0) {
+            int batch = elapsed * exp_num_batches / duration_ns;
+            exp_batch = (batch < exp_num_batches) ? batch : exp_num_batches - 1;
+            if (elapsed >= duration_ns) break;
+        }
+    }
+    exp_stop = true;
+    while (exp_done_threads < tnum) {}
+
+    exp_end_ns = exp_start_ns;
+    for (int tid = 0; tid < tnum; tid++)
+        if (exp_counters[tid].end_ns > exp_end_ns) exp_end_ns = exp_counters[tid].end_ns;
+}
+
+uint64_t exp_phase_ops(int tnum) {
+    return exp_total_ops(tnum);
+}
+
+// wall time throughput of the last phase, in Mops/s
+double exp_phase_throughput(int tnum) {
+    double elapsed_ms = (exp_end_ns - exp_start_ns) / 1e6;
+    return elapsed_ms > 0 ? exp_total_ops(tnum) / elapsed_ms / 1000 : 0;
+}
+
+// prints wall time throughput (Mops/s) and the per-interval time series.
+void exp_phase_print(int tnum) {
+    uint64_t ops = exp_total_ops(tnum);
+    double elapsed_ms = (exp_end_ns - exp_start_ns) / 1e6;
+    std::cout << "Operations:   " << ops << std::endl;
+    std::cout << "Elapsed_ms:   " << elapsed_ms << std::endl;
+    std::cout << "Throughput:   " << (elapsed_ms > 0 ? ops / elapsed_ms / 1000 : 0) << std::endl;
+
+    std::cout << "Throughput_series_interval_ms=" << exp_interval_ms << " Mops/s:";
+    uint64_t prev_ns = exp_start_ns;
+    uint64_t prev_ops = 0;
+    for (size_t i = 0; i < exp_samples.size(); i++) {
+        // the last interval may have been cut short by the end of the phase
+        uint64_t t = std::min(exp_samples[i].first, exp_end_ns);
+        if (t <= prev_ns) break;
+        std::cout << " " << (exp_samples[i].second - prev_ops) * 1000.0 / (t - prev_ns);
+        prev_ns = t;
+        prev_ops = exp_samples[i].second;
+    }
+    std::cout << std::endl;
+}
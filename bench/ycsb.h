@@ -0,0 +1,205 @@
+#pragma once
+
+/**
+ * YCSB-style workload engine: the core workloads A-F, or any custom mix of
+ * get / update / scan / insert / remove / rmw (read-modify-write) operations.
+ *
+ * Records are numbered 0, 1, 2, ...: the load phase inserts records
+ * [0, ninit), and every insert during the run takes the next unused record
+ * number, so the "latest" distribution can favour recent inserts. The key of
+ * record r is ycsb_key(r), which scatters consecutive records over the key
+ * space (like YCSB's hashed insert order).
+ *
+ * Request distributions (used by every operation except insert):
+ *   uniform   any record inserted so far, with equal probability
+ *   zipfian   zipf(skew) over the loaded records, popular records scattered
+ *   latest    zipf(skew) over recency: the newest record is the most popular
+ *   pim       keys (for inserts too) come from the PIM partitioned
+ *             distribution of the search/insert phases instead of records
+ *
+ * zipfian and latest sample ranks from a distribution built over the loaded
+ * record count, so records inserted during the run are only reached by latest
+ * and uniform. This is close to YCSB as long as inserts are a small fraction.
+ *
+ * A YCSB scan reads L records starting at a key. rangeQuery takes a key
+ * interval instead, so a scan of length L from key k reads [k, k + L * gap],
+ * where gap is the average distance between two keys. Since keys are not
+ * evenly spaced, the interval may hold more records; the driver's scans stop
+ * after max_scan_len of them.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+
+#include "plaf.h"
+#include "pim_exp.hpp"
+#include "zipf.h"
+
+#define YCSB_DIST_UNIFORM 0
+#define YCSB_DIST_ZIPFIAN 1
+#define YCSB_DIST_LATEST 2
+#define YCSB_DIST_PIM 3
+#define YCSB_NUM_DISTS 4
+const char * const ycsb_dist_names[YCSB_NUM_DISTS] = {"uniform", "zipfian", "latest", "pim"};
+
+struct ycsb_workload {
+    double mix[OPERATION_NR_ITEMS]; // fraction of the operations of each type
+    int request_dist;
+    int scan_dist;                  // YCSB_DIST_UNIFORM or YCSB_DIST_ZIPFIAN
+    int max_scan_len;
+};
+
+ycsb_workload ycsb = {{0}, YCSB_DIST_ZIPFIAN, YCSB_DIST_UNIFORM, 100};
+bool ycsb_enabled = false;
+
+double ycsb_mix_cumsum[OPERATION_NR_ITEMS];
+int ycsb_last_op = 0;
+int64_t ycsb_key_range;
+int64_t ycsb_loaded_records;
+rand_distribution ycsb_record_dist;
+rand_distribution ycsb_scan_dist;
+
+PAD;
+volatile int64_t ycsb_next_record = 0; // number of records inserted (or being inserted) so far
+PAD;
+
+// selects YCSB core workload A-F (operation mix and distributions).
+bool ycsb_set_workload(const char * name) {
+    if (strlen(name) != 1) return false;
+    memset(ycsb.mix, 0, sizeof(ycsb.mix));
+    ycsb.request_dist = YCSB_DIST_ZIPFIAN;
+    ycsb.scan_dist = YCSB_DIST_UNIFORM;
+    switch (name[0]) {
+        case 'a': case 'A': ycsb.mix[get_t] = 0.5;  ycsb.mix[update_t] = 0.5;  break;
+        case 'b': case 'B': ycsb.mix[get_t] = 0.95; ycsb.mix[update_t] = 0.05; break;
+        case 'c': case 'C': ycsb.mix[get_t] = 1;                               break;
+        case 'd': case 'D': ycsb.mix[get_t] = 0.95; ycsb.mix[insert_t] = 0.05;
+                            ycsb.request_dist = YCSB_DIST_LATEST;              break;
+        case 'e': case 'E': ycsb.mix[scan_t] = 0.95; ycsb.mix[insert_t] = 0.05; break;
+        case 'f': case 'F': ycsb.mix[get_t] = 0.5;  ycsb.mix[rmw_t] = 0.5;     break;
+        default: return false;
+    }
+    return true;
+}
+
+// sets a custom operation mix from a list like "get=0.9,insert=0.05,remove=0.05".
+// fractions are normalized to sum to 1.
+bool ycsb_set_mix(const char * spec) {
+    memset(ycsb.mix, 0, sizeof(ycsb.mix));
+    string s(spec);
+    size_t pos = 0;
+    while (pos < s.size()) {
+        size_t end = s.find(',', pos);
+        if (end == string::npos) end = s.size();
+        string item = s.substr(pos, end - pos);
+        size_t eq = item.find('=');
+        if (eq == string::npos) return false;
+        string name = item.substr(0, eq);
+        int op = 0;
+        while (op < OPERATION_NR_ITEMS && name != operation_names[op]) op++;
+        if (op == OPERATION_NR_ITEMS || op == empty_t) return false;
+        ycsb.mix[op] = atof(item.substr(eq + 1).c_str());
+        if (ycsb.mix[op] < 0) return false;
+        pos = end + 1;
+    }
+    double total = 0;
+    for (int op = 0; op < OPERATION_NR_ITEMS; op++) total += ycsb.mix[op];
+    if (total <= 0) return false;
+    for (int op = 0; op < OPERATION_NR_ITEMS; op++) ycsb.mix[op] /= total;
+    return true;
+}
+
+// the mix of the original -rw option: finds with probability ratio, inserts
+// otherwise, all on keys from the PIM distribution.
+void ycsb_set_rw(double ratio) {
+    memset(ycsb.mix, 0, sizeof(ycsb.mix));
+    ycsb.mix[get_t] = ratio;
+    ycsb.mix[insert_t] = 1 - ratio;
+    ycsb.request_dist = YCSB_DIST_PIM;
+}
+
+bool ycsb_parse_dist(const char * name, int * dist) {
+    for (int i = 0; i < YCSB_NUM_DISTS; i++) {
+        if (strcmp(name, ycsb_dist_names[i]) == 0) {
+            *dist = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// do the load phase and the run use record keys (rather than random or file keys)?
+static inline bool ycsb_record_keys() {
+    return ycsb_enabled && ycsb.request_dist != YCSB_DIST_PIM;
+}
+
+static inline int64_t ycsb_key(uint64_t record) {
+    return (int64_t) (mix(record) % ycsb_key_range);
+}
+
+// must be called before the load phase, which inserts records [0, records).
+void ycsb_init(int64_t records, double skew, int64_t key_range) {
+    ycsb_key_range = key_range;
+    ycsb_loaded_records = records;
+    ycsb_next_record = records;
+
+    double total = 0;
+    for (int op = 0; op < OPERATION_NR_ITEMS; op++) {
+        total += ycsb.mix[op];
+        ycsb_mix_cumsum[op] = total;
+        if (ycsb.mix[op] > 0) ycsb_last_op = op;
+    }
+
+    if (ycsb.request_dist == YCSB_DIST_ZIPFIAN)
+        rand_zipf_init(&ycsb_record_dist, records, skew);
+    else if (ycsb.request_dist == YCSB_DIST_LATEST)
+        rand_zipf_rank_init(&ycsb_record_dist, records, skew);
+    if (ycsb.scan_dist == YCSB_DIST_ZIPFIAN)
+        rand_zipf_rank_init(&ycsb_scan_dist, ycsb.max_scan_len, skew);
+}
+
+static inline operation_t ycsb_next_op(int tid) {
+    double x = rand_double(tid);
+    int op = 0;
+    while (op < ycsb_last_op && x >= ycsb_mix_cumsum[op]) op++;
+    return (operation_t) op;
+}
+
+// record number for a new insert
+static inline int64_t ycsb_new_record() {
+    return __sync_fetch_and_add(&ycsb_next_record, 1);
+}
+
+// record number for any other operation
+static inline int64_t ycsb_request_record(int tid) {
+    int64_t records = ycsb_next_record;
+    if (ycsb.request_dist == YCSB_DIST_UNIFORM)
+        return rand_range(tid, records);
+    if (ycsb.request_dist == YCSB_DIST_ZIPFIAN)
+        return rand_dist(&ycsb_record_dist, tid);
+    int64_t record = records - 1 - (int64_t) rand_dist(&ycsb_record_dist, tid);
+    return (record > 0) ? record : 0;
+}
+
+// last key of a scan that starts at key start
+static inline int64_t ycsb_scan_end(int tid, int64_t start) {
+    uint64_t len = 1 + ((ycsb.scan_dist == YCSB_DIST_ZIPFIAN)
+            ? rand_dist(&ycsb_scan_dist, tid)
+            : rand_range(tid, ycsb.max_scan_len));
+    uint64_t gap = ycsb_key_range / ycsb_next_record;
+    uint64_t room = ycsb_key_range - 1 - start;
+    return start + ((len > room / gap) ? room : len * gap);
+}
+
+void ycsb_print() {
+    cout << "ycsb_mix:";
+    for (int op = 0; op < OPERATION_NR_ITEMS; op++)
+        if (ycsb.mix[op] > 0) cout << " " << operation_names[op] << "=" << ycsb.mix[op];
+    cout << endl;
+    cout << "ycsb_request_dist=" << ycsb_dist_names[ycsb.request_dist];
+    if (ycsb.mix[scan_t] > 0)
+        cout << " ycsb_scan_dist=" << ycsb_dist_names[ycsb.scan_dist] << " ycsb_max_scan_len=" << ycsb.max_scan_len;
+    cout << endl;
+}
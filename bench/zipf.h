@@ -0,0 +1,377 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <assert.h>
+#include <time.h>
+
+#include <sys/mman.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "plaf.h"
+#include "thread_state.h"
+
+// Sample a number in [0,max) with all numbers having equal probability.
+#define DIST_UNIFORM 0
+
+// Sample a number in [0,max) with Zipf probabilities: the k'th most
+// common number has probability proportional to 1 / (k**skew).
+#define DIST_ZIPF 1
+
+// Same as DIST_ZIPF, but with 0 being the most common number, 1 the
+// second most common, and so on.
+#define DIST_ZIPF_RANK 2
+
+// Zipf ranks are drawn in O(1): with an alias table (one random number and
+// one table lookup per draw) when there are at most ZIPF_ALIAS_MAX ranks, so
+// that the table stays in L2, and by rejection-inversion (Hormann and
+// Derflinger, "Rejection-inversion to generate variates from monotone
+// discrete distributions", 1996) otherwise, which needs no table at all.
+#define ZIPF_ALIAS_MAX (1 << 14)
+
+// every thread's generator state sits on its own cache line
+struct rand_thread_state {
+	uint64_t s;
+	long int seeds_given;	// see seed_and_print
+	char pad[PREFETCH_SIZE_BYTES - sizeof(uint64_t) - sizeof(long int)];
+};
+rand_thread_state rand_state[MAX_THREADS_POW2] __attribute__((aligned(PREFETCH_SIZE_BYTES)));
+
+static void rand_seed(uint64_t s, int tid) {
+	thread_state_check(tid, "rand_seed");
+	rand_state[tid].s = s;
+}
+
+static inline uint32_t rand_dword(int tid) {
+	rand_state[tid].s = 6364136223846793005 * rand_state[tid].s + 1;
+	return rand_state[tid].s >> 32;
+}
+
+static uint32_t rand_dword_r(uint64_t* state) {
+	*state = 6364136223846793005 * (*state) + 1;
+	return (*state) >> 32;
+}
+
+static inline uint64_t rand_uint64(int tid) {
+	return (((uint64_t)rand_dword(tid)) << 32) + rand_dword(tid);
+}
+
+// maps x in [0,2^64) to [0,n), without the division of x % n
+static inline uint64_t scale_to_range(uint64_t x, uint64_t n) {
+	return (uint64_t) (((unsigned __int128) x * n) >> 64);
+}
+
+// a number in [0,n) with all numbers having equal probability
+static inline uint64_t rand_range(int tid, uint64_t n) {
+	return scale_to_range(rand_uint64(tid), n);
+}
+
+static float rand_float(int tid) {
+	return ((float)rand_dword(tid)) / UINT32_MAX;
+}
+
+static void random_bytes(uint8_t* buf, int count, int tid) {
+	int i;
+	for (i = 0;i < count;i++)
+		buf[i] = rand_dword(tid) % 256;
+}
+
+// with rand_base_seed >= 0, seed_and_print derives the seeds from it instead
+// of the clock, so the k'th seed handed to thread tid is the same in every run
+long int rand_base_seed = -1;
+
+static long int seed_and_print(int tid) {
+	struct timeval now;
+	long int seed;
+	thread_state_check(tid, "seed_and_print");
+	if (rand_base_seed >= 0) {
+		seed = rand_base_seed + tid * 10000 + rand_state[tid].seeds_given++ * 1000000007L;
+	}
+	else {
+		gettimeofday(&now, NULL);
+		seed = now.tv_sec * 1000000 + now.tv_usec + tid * 10000;
+	}
+	// printf("Using seed %ld\n", seed);
+	rand_seed(seed, tid);
+	return seed;
+}
+
+typedef struct {
+	// rank i is kept with probability threshold / 2^32, otherwise it is replaced by alias
+	uint32_t threshold;
+	uint32_t alias;
+} zipf_alias_entry;
+
+typedef struct {
+	// alias table of the ranks, or NULL to use rejection-inversion.
+	// tables are immutable and shared by all distributions with the same max and skew.
+	zipf_alias_entry* alias_table;
+
+	// rejection-inversion constants
+	double h_integral_x1;
+	double h_integral_max;
+	double s;
+
+	double skew;
+	uint64_t max;
+	int type;
+} rand_distribution;
+
+rand_distribution zipf_dist_cache;
+
+static inline double rand_double(int tid) {
+	return ((double)rand_uint64(tid)) / UINT64_MAX;
+}
+
+void rand_uniform_init(rand_distribution* dist, uint64_t max) {
+	dist->max = max;
+	dist->type = DIST_UNIFORM;
+}
+
+// log1p(x) / x, accurate near 0
+static inline double zipf_helper1(double x) {
+	return (fabs(x) > 1e-8) ? log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+}
+
+// expm1(x) / x, accurate near 0
+static inline double zipf_helper2(double x) {
+	return (fabs(x) > 1e-8) ? expm1(x) / x : 1 + x * 0.5 * (1 + x / 3 * (1 + 0.25 * x));
+}
+
+// h(x) = x^-skew, the (unnormalized) density that is integrated below
+static inline double zipf_h(double skew, double x) {
+	return exp(-skew * log(x));
+}
+
+// H(x), an antiderivative of h
+static inline double zipf_h_integral(double skew, double x) {
+	double log_x = log(x);
+	return zipf_helper2((1 - skew) * log_x) * log_x;
+}
+
+static inline double zipf_h_integral_inverse(double skew, double x) {
+	double t = x * (1 - skew);
+	if (t < -1) t = -1; // guards against rounding errors
+	return exp(zipf_helper1(t) * x);
+}
+
+static zipf_alias_entry* zipf_alias_build(uint64_t max, double skew) {
+	zipf_alias_entry* table = (zipf_alias_entry*) malloc(max * sizeof(zipf_alias_entry));
+	double* p = (double*) malloc(max * sizeof(double));
+	uint64_t* small = (uint64_t*) malloc(max * sizeof(uint64_t));
+	uint64_t* large = (uint64_t*) malloc(max * sizeof(uint64_t));
+	uint64_t num_small = 0, num_large = 0;
+	uint64_t i;
+
+	double total_weight = 0.0;
+	for (i = 0;i < max;i++)
+		total_weight += 1.0 / pow(i + 1, skew);
+	// scale so that the average probability is 1
+	for (i = 0;i < max;i++) {
+		p[i] = max / pow(i + 1, skew) / total_weight;
+		if (p[i] < 1) small[num_small++] = i;
+		else large[num_large++] = i;
+	}
+	while (num_small > 0 && num_large > 0) {
+		uint64_t l = small[--num_small];
+		uint64_t g = large[--num_large];
+		table[l].threshold = (uint32_t) (p[l] * 4294967296.0);
+		table[l].alias = g;
+		p[g] = (p[g] + p[l]) - 1;
+		if (p[g] < 1) small[num_small++] = g;
+		else large[num_large++] = g;
+	}
+	// whatever is left has probability 1, up to rounding
+	while (num_large > 0) {
+		uint64_t g = large[--num_large];
+		table[g].threshold = UINT32_MAX;
+		table[g].alias = g;
+	}
+	while (num_small > 0) {
+		uint64_t l = small[--num_small];
+		table[l].threshold = UINT32_MAX;
+		table[l].alias = l;
+	}
+
+	free(p);
+	free(small);
+	free(large);
+	return table;
+}
+
+void rand_zipf_init(rand_distribution* dist, uint64_t max, double skew) {
+	if (zipf_dist_cache.max == max && zipf_dist_cache.skew == skew) {
+		*dist = zipf_dist_cache;
+		return;
+	}
+
+	if (max <= ZIPF_ALIAS_MAX) {
+		// the previous table may still be used by other distributions, so it is never freed
+		dist->alias_table = zipf_alias_build(max, skew);
+	} else {
+		dist->alias_table = NULL;
+		dist->h_integral_x1 = zipf_h_integral(skew, 1.5) - 1;
+		dist->h_integral_max = zipf_h_integral(skew, max + 0.5);
+		dist->s = 2 - zipf_h_integral_inverse(skew, zipf_h_integral(skew, 2.5) - zipf_h(skew, 2));
+	}
+	dist->max = max;
+	dist->type = DIST_ZIPF;
+	dist->skew = skew;
+
+	zipf_dist_cache = *dist;
+}
+
+void rand_zipf_rank_init(rand_distribution* dist, uint64_t max, double skew) {
+	rand_zipf_init(dist, max, skew);
+	dist->type = DIST_ZIPF_RANK;
+}
+
+static inline uint64_t mix(uint64_t x) {
+	x ^= x >> 33;
+	x *= 0xC2B2AE3D27D4EB4FULL;  // Random prime
+	x ^= x >> 29;
+	x *= 0x165667B19E3779F9ULL;  // Random prime
+	x ^= x >> 32;
+	return x;
+}
+
+// a Zipf rank in [0,max): 0 is the most common
+static inline uint64_t rand_zipf_rank(rand_distribution* dist, int tid) {
+	if (dist->alias_table != NULL) {
+		uint64_t r = rand_uint64(tid);
+		uint64_t i = ((r >> 32) * dist->max) >> 32;
+		return ((uint32_t) r < dist->alias_table[i].threshold) ? i : dist->alias_table[i].alias;
+	}
+
+	// rejection-inversion; accepts within about 1.1 tries on average
+	while (1) {
+		double u = dist->h_integral_max + rand_double(tid) * (dist->h_integral_x1 - dist->h_integral_max);
+		double x = zipf_h_integral_inverse(dist->skew, u);
+		uint64_t k = (uint64_t) (x + 0.5);
+		if (k < 1) k = 1;
+		else if (k > dist->max) k = dist->max;
+		if (k - x <= dist->s || u >= zipf_h_integral(dist->skew, k + 0.5) - zipf_h(dist->skew, k))
+			return k - 1;
+	}
+}
+
+static inline uint64_t rand_dist(rand_distribution* dist, int tid) {
+	if (dist->type == DIST_UNIFORM)
+		return rand_range(tid, dist->max);
+
+	uint64_t zipf_rand = rand_zipf_rank(dist, tid);
+
+	if (dist->type == DIST_ZIPF) {
+		// Permute the output. Otherwise, all common values will be near one another
+		assert(dist->max > 1000);  // When <max> is small, collisions change the distribution considerably.
+		return scale_to_range(mix(zipf_rand), dist->max);
+	} else {
+		assert(dist->type == DIST_ZIPF_RANK);
+		return zipf_rand;
+	}
+}
+
+// upper bound on the number of partitions of a hotspot distribution
+#define MAX_HOTSPOT_PARTITIONS (1 << 16)
+#define MAX_HOTSPOT_SKEWS 64
+
+typedef struct {
+	// the rank r partition is (mult * r + offset) % num_partitions
+	uint32_t mult;
+	uint32_t offset;
+	rand_distribution* ranks;
+} hotspot_phase;
+
+// Shifting hotspot: [0,idx_max) is split into num_partitions equal partitions,
+// and a key is drawn from a partition chosen with Zipf probabilities. Which
+// partitions are hot changes from phase to phase by a cheap permutation of
+// the ranks, so all phases share the rank tables of their skews.
+typedef struct {
+	uint32_t num_partitions;
+	uint64_t partition_size;
+	int num_phases;
+	hotspot_phase* phases;
+	rand_distribution* skew_dists; // one per distinct skew
+} hotspot_distribution;
+
+static uint32_t gcd32(uint32_t a, uint32_t b) {
+	while (b != 0) {
+		uint32_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+static uint32_t rand_coprime(uint32_t n, int tid) {
+	if (n == 1) return 1;
+	uint32_t m;
+	do {
+		m = 1 + rand_range(tid, n - 1);
+	} while (gcd32(m, n) != 1);
+	return m;
+}
+
+// phase i uses skews[i % num_skews]. with shift >= 0, the hot set of every phase
+// is that of the previous phase moved by shift partitions (so shift 0 keeps it
+// in place); with shift < 0, every phase gets an unrelated random hot set.
+void rand_hotspot_init(hotspot_distribution* dist, uint32_t num_partitions, uint64_t idx_max, int num_phases,
+		int64_t shift, const double* skews, int num_skews) {
+	int i, j;
+	dist->num_partitions = num_partitions;
+	dist->partition_size = idx_max / num_partitions;
+	dist->num_phases = num_phases;
+	dist->phases = (hotspot_phase*) malloc(num_phases * sizeof(hotspot_phase));
+	dist->skew_dists = (rand_distribution*) malloc(num_skews * sizeof(rand_distribution));
+
+	for (i = 0;i < num_skews;i++) {
+		for (j = 0;j < i && skews[j] != skews[i];j++);
+		if (j < i) dist->skew_dists[i] = dist->skew_dists[j];
+		else rand_zipf_rank_init(&(dist->skew_dists[i]), num_partitions, skews[i]);
+	}
+
+	uint32_t mult = rand_coprime(num_partitions, 0);
+	uint32_t offset = rand_range(0, num_partitions);
+	for (i = 0;i < num_phases;i++) {
+		if (shift < 0) {
+			mult = rand_coprime(num_partitions, 0);
+			offset = rand_range(0, num_partitions);
+		}
+		dist->phases[i].mult = mult;
+		dist->phases[i].offset = (shift < 0) ? offset : (offset + (uint64_t) shift * i) % num_partitions;
+		dist->phases[i].ranks = &(dist->skew_dists[i % num_skews]);
+	}
+}
+
+// parses a comma separated list of skews, returns how many (0 on error)
+int parse_hotspot_skews(const char* spec, double* skews) {
+	int n = 0;
+	char* end;
+	while (n < MAX_HOTSPOT_SKEWS) {
+		skews[n] = strtod(spec, &end);
+		if (end == spec || skews[n] < 0) return 0;
+		n++;
+		if (*end == '\0') return n;
+		if (*end != ',') return 0;
+		spec = end + 1;
+	}
+	return 0;
+}
+
+void rand_hotspot_free(hotspot_distribution* dist) {
+	free(dist->phases);
+	free(dist->skew_dists);
+}
+
+static inline uint64_t rand_hotspot(hotspot_distribution* dist, int phase, int tid) {
+	hotspot_phase* p = &(dist->phases[phase]);
+	uint32_t rank = rand_zipf_rank(p->ranks, tid);
+	uint32_t partition = (p->mult * rank + p->offset) % dist->num_partitions;
+	return partition * dist->partition_size + rand_range(tid, dist->partition_size);
+}
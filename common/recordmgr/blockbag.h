@@ -8,6 +8,7 @@
 #ifndef BLOCKLIST_H
 #define	BLOCKLIST_H
 
+#include <atomic>
 #include <cassert>
 #include <iostream>
 #include "blockpool.h"
@@ -269,6 +270,7 @@ class block;
     public:
         int sizeInBlocks;
     private:
+        std::atomic<int> numElements; // see estimateSize
 
         block<T> *head;
         block<T> *tail;
@@ -290,6 +292,13 @@ class block;
             }
             // invariant: sizeInBlocks is correct
             assert(sizeInBlocks == computeSizeInBlocks());
+            // invariant: numElements is correct
+            assert(numElements.load(std::memory_order_relaxed) == computeSize());
+        }
+
+        // only the owner changes numElements, so it needs no read-modify-write
+        inline void addToSize(const int delta) {
+            numElements.store(numElements.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
         }
 
         void debugPrintBag() {
@@ -319,6 +328,7 @@ class block;
             reclaimCount = 0;
             debugFreed = 0;
             sizeInBlocks = 1;
+            numElements.store(0, std::memory_order_relaxed);
             head = pool->allocateBlock(NULL);
             tail = head;
             DEBUG2 assert(computeSizeInBlocks() == sizeInBlocks);
@@ -367,6 +377,7 @@ class block;
             DEBUG2 validate();
             int oldsize; DEBUG2 oldsize = computeSize();
             head->push(obj);
+            addToSize(1);
             if (head->isFull()) {
                 int oldNumBlocks; DEBUG2 oldNumBlocks = computeSizeInBlocks();
                 block<T> *newblock = pool->allocateBlock(head);
@@ -386,6 +397,7 @@ class block;
             DEBUG2 validate();
             int oldsize; DEBUG2 oldsize = computeSize();
             head->push(obj);
+            addToSize(1);
             if (head->isFull()) {
                 int oldNumBlocks; DEBUG2 oldNumBlocks = computeSizeInBlocks();
                 block<T> *newblock = pool->allocateBlock(head);
@@ -427,6 +439,7 @@ class block;
                 --sizeInBlocks;
             }
             assert(!head->isEmpty());
+            addToSize(-1);
 
             // case 1: curr is the new head
             if (curr == head) {
@@ -455,6 +468,7 @@ class block;
             DEBUG2 validate();
             int oldsize; DEBUG2 oldsize = computeSize();
             T *result;
+            addToSize(-1);
             if (head->isEmpty()) {
                 result = head->next->pop();
                 int oldNumBlocks; DEBUG2 oldNumBlocks = computeSizeInBlocks();
@@ -483,6 +497,7 @@ class block;
             if (head->isEmpty()) {
                 if (head->next) {
                     result = head->next->pop();
+                    addToSize(-1);
                     int oldNumBlocks; DEBUG2 oldNumBlocks = computeSizeInBlocks();
                     block<T> * const temp = head;
                     head = head->next;
@@ -532,6 +547,7 @@ class block;
             } else {
 //                MEMORY_STATS2 alloc->debug->addFromPool(tid, 1);
                 result = head->pop();
+                addToSize(-1);
                 DEBUG2 validate();
                 return result;
             }
@@ -550,6 +566,7 @@ class block;
                     head->next = second->next;
                     second->next = NULL; // not technically necessary, but safer
                     --sizeInBlocks;
+                    addToSize(-(int) BLOCK_SIZE);
                     DEBUG2 assert(oldNumBlocks - 1 == computeSizeInBlocks());
                     DEBUG2 assert(oldsize - BLOCK_SIZE == computeSize());
                     DEBUG2 assert(sizeInBlocks == computeSizeInBlocks());
@@ -572,6 +589,7 @@ class block;
             tail->next = b;
             tail = b;
             ++sizeInBlocks;
+            addToSize(BLOCK_SIZE);
             DEBUG2 assert(oldNumBlocks + 1 == computeSizeInBlocks());
             DEBUG2 assert(oldsize + BLOCK_SIZE == computeSize());
             DEBUG2 assert(sizeInBlocks == computeSizeInBlocks());
@@ -631,10 +649,15 @@ class block;
             if (predecessor->next != NULL) {
                 DEBUG2 assert(predecessor->next->computeSize() == BLOCK_SIZE);
                 assert(predecessor->next->isFull());
+                const int oldSizeInBlocks = sizeInBlocks;
                 tail->next = predecessor->next;
                 tail = other->tail;
                 assert(head && tail);
                 sizeInBlocks = computeSizeInBlocks();
+                // the moved blocks are all full
+                const int moved = (sizeInBlocks - oldSizeInBlocks) * BLOCK_SIZE;
+                addToSize(moved);
+                other->addToSize(-moved);
                 // remove all blocks after predecessor in the other bag
                 predecessor->next = NULL;
                 other->tail = predecessor;
@@ -669,6 +692,14 @@ class block;
         int getSizeInBlocks() {
             return sizeInBlocks;
         }
+        // the same as computeSize(), from a counter the owner updates as it
+        // adds and removes elements and blocks. other threads may call this
+        // while the owner changes the bag: it reads only the counter, never
+        // the blocks (which the pool may free meanwhile), and may miss the
+        // owner's latest changes.
+        int estimateSize() {
+            return numElements.load(std::memory_order_relaxed);
+        }
         // this function is occasionally useful if, for instance,
         // you use a bump allocator, which hands out objects from
         // a huge slab of memory.
@@ -695,6 +726,7 @@ class block;
             tail = head;
             head->clearWithoutFreeingElements();
             sizeInBlocks = 1;
+            numElements.store(0, std::memory_order_relaxed);
             DEBUG2 validate();
         }
     };
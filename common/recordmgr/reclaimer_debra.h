@@ -110,13 +110,15 @@ public:
         SOFTWARE_BARRIER;
     }
 
+    // nodes waiting in epoch bags. may be called while other threads run
+    // operations (see blockbag::estimateSize).
     long long getSizeInNodes() {
         long long sum = 0;
         //std::cout<<"NUM_PROC="<<this->NUM_PROCESSES<<std::endl;
         for (int tid=0;tid<this->NUM_PROCESSES;++tid) {
             for (int j=0;j<NUMBER_OF_EPOCH_BAGS;++j) {
                 if (threadData[tid].epochbags[j]) {
-                    sum += threadData[tid].epochbags[j]->computeSize();
+                    sum += threadData[tid].epochbags[j]->estimateSize();
                 }
             }
         }
@@ -102,7 +102,7 @@ public:
         long long sum = 0;
         for (int tid=0;tid<this->NUM_PROCESSES;++tid) {
             for (int j=0;j<NUMBER_OF_EPOCH_BAGS;++j) {
-                sum += threadData[tid].epochbags[j]->computeSize();
+                sum += threadData[tid].epochbags[j]->estimateSize();
             }
         }
         return sum;
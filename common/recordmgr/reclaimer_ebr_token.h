@@ -61,8 +61,8 @@ public:
     long long getSizeInNodes() {
         long long sum = 0;
         for (int tid=0;tid<this->NUM_PROCESSES;++tid) {
-            sum += threadData[tid].curr->computeSize();
-            sum += threadData[tid].last->computeSize();
+            sum += threadData[tid].curr->estimateSize();
+            sum += threadData[tid].last->estimateSize();
         }
         return sum;
     }
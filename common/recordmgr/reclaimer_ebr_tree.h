@@ -253,7 +253,7 @@ public:
         long long sum = 0;
         for (int tid=0;tid<this->NUM_PROCESSES;++tid) {
             for (int j=0;j<NUMBER_OF_EPOCH_BAGS;++j) {
-                sum += thread_data[tid].epochbags[j]->computeSize();
+                sum += thread_data[tid].epochbags[j]->estimateSize();
             }
         }
         return sum;
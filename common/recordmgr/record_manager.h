@@ -215,6 +215,18 @@ public:
     inline record_manager_single_type<T, Reclaim, Alloc, Pool> * get(T * const recordType) {
         return rmset->get((T *) NULL);
     }
+    // how many records of type T are allocated and not yet freed (as counted
+    // by the allocator when MEMORY_STATS is enabled), how many of those are
+    // retired and waiting in the reclaimer's limbo bags (0 for reclaimers
+    // without bags), and how many have been freed so far. may be called while
+    // other threads run operations, in which case the counts are slightly stale.
+    template <typename T>
+    void getMemoryStats(T * const recordType, long long * const outstanding, long long * const limbo, long long * const freed) {
+        record_manager_single_type<T, Reclaim, Alloc, Pool> * const mgr = rmset->get((T *) NULL);
+        *freed = mgr->debugInfoRecord.getTotalDeallocated();
+        *outstanding = mgr->debugInfoRecord.getTotalAllocated() - *freed;
+        *limbo = mgr->reclaim->getSizeInNodes();
+    }
 
     // for hazard pointers
 
@@ -60,6 +60,7 @@ public:
     bool contains(const int tid, const K& key) {
         return tree->find(tid, key) != getNoValue();
     }
+    #define DS_ADAPTER_SUPPORTS_INSERT_REPLACE
     V insert(const int tid, const K& key, const V& val) {
         return tree->insertReplace(tid, key, val);
     }
@@ -72,7 +73,21 @@ public:
     V find(const int tid, const K& key) {
         return tree->find(tid, key);
     }
-    int rangeQuery(const int tid, const K& lo, const K& hi, K * const resultKeys, V * const resultValues) {
+    // the value of the largest key <= key (predecessor), the smallest key > key
+    // (successor) or the smallest key >= key (lowerBound), and that key in
+    // outKey, or getNoValue() if there is none. not linearizable (see
+    // ccavl::predecessor)
+    #define DS_ADAPTER_SUPPORTS_ORDERED_SEARCH
+    V predecessor(const int tid, const K& key, K * const outKey) {
+        return tree->predecessor(tid, key, outKey);
+    }
+    V successor(const int tid, const K& key, K * const outKey) {
+        return tree->successor(tid, key, outKey);
+    }
+    V lowerBound(const int tid, const K& key, K * const outKey) {
+        return tree->lowerBound(tid, key, outKey);
+    }
+    int rangeQuery(const int tid, const K& lo, const K& hi, K * const resultKeys, V * const resultValues, const int capacity) {
         setbench_error("rangeQuery not implemented for this data structure");
     }
     void printSummary() {
@@ -90,6 +105,14 @@ public:
     void debugGCSingleThreaded() {
         tree->debugGetRecMgr()->debugGCSingleThreaded();
     }
+    #define DS_ADAPTER_SUPPORTS_MEMORY_STATS
+    // the size of a node, how many nodes are allocated and not yet freed, how
+    // many of those are retired and waiting to be reclaimed, and how many have
+    // been freed (may be called during a run, see record_manager::getMemoryStats)
+    void getMemoryStats(size_t * const nodeBytes, long long * const outstanding, long long * const limbo, long long * const freed) {
+        *nodeBytes = sizeof(NODE_T);
+        tree->debugGetRecMgr()->getMemoryStats((NODE_T *) NULL, outstanding, limbo, freed);
+    }
 
 #ifdef USE_TREE_STATS
     class NodeHandler {
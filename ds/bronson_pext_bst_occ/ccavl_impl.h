@@ -30,6 +30,8 @@
 #ifndef CCAVL_H
 #define CCAVL_H
 
+#include <vector>
+#include <utility>
 #include "record_manager.h"
 
 //#if  (INDEX_STRUCT == IDX_CCAVL_SPIN)
@@ -200,6 +202,17 @@ private:
         char dirToC,
         version_t nodeOVL);
 
+    // the nodes an ordered lookup visited, with their versions, for validation
+    struct NavThreadData {
+        std::vector<std::pair<node_t<skey_t, sval_t>*, version_t> > nodes;
+        PAD;
+    };
+    NavThreadData * const navThreadData;
+    bool navVisit(const int tid, node_t<skey_t, sval_t>* parent, char dir, node_t<skey_t, sval_t>** child);
+    bool navSearch(const int tid, node_t<skey_t, sval_t>* parent, char dir, skey_t key, bool bounded,
+            const bool forward, const bool inclusive, skey_t * const outKey, sval_t * const outValue);
+    sval_t navigate(const int tid, skey_t key, const bool forward, const bool inclusive, skey_t * const outKey);
+
     int shouldUpdate(int func, sval_t prev, sval_t expected);
     int nodeCondition(node_t<skey_t, sval_t>* curr);
     node_t<skey_t, sval_t>* fixHeight_nl(node_t<skey_t, sval_t>* curr);
@@ -219,6 +232,7 @@ public:
 
     ccavl(const int numProcesses, const skey_t& _KEY_NEG_INFTY)
     : recmgr(new RecMgr(numProcesses, SIGQUIT))
+    , navThreadData(new NavThreadData[numProcesses])
     , NUM_PROCESSES(numProcesses)
     , KEY_NEG_INFTY(_KEY_NEG_INFTY) {
         const int tid = 0;
@@ -290,6 +304,7 @@ public:
 //        std::cout<<"  deallocated "<<numNodes<<std::endl;
         recmgr->printStatus();
         delete recmgr;
+        delete[] navThreadData;
     }
 
     void initThread(const int tid) {
@@ -320,6 +335,29 @@ public:
         return remove_node(tid, root, key);
     }
 
+    /**
+     * Ordered lookups: the value of the largest key <= key (predecessor), the
+     * smallest key > key (successor) or the smallest key >= key (lowerBound),
+     * with that key in outKey, or NULL if there is none. The search descends
+     * towards key and backtracks past nodes without a value (routing nodes of
+     * removed keys), recording the version of every node it reads, and starts
+     * over if one of them was shrinking or shrank (was rotated down or
+     * unlinked) before the search ended. A key that stays in the tree for the
+     * whole lookup is therefore not skipped, but the lookup is not atomic with
+     * respect to concurrent inserts and removals of the keys it compares.
+     */
+    sval_t predecessor(const int tid, skey_t key, skey_t * const outKey) {
+        return navigate(tid, key, false, true, outKey);
+    }
+
+    sval_t successor(const int tid, skey_t key, skey_t * const outKey) {
+        return navigate(tid, key, true, false, outKey);
+    }
+
+    sval_t lowerBound(const int tid, skey_t key, skey_t * const outKey) {
+        return navigate(tid, key, true, true, outKey);
+    }
+
     node_t<skey_t, sval_t> * get_root() {
         return root;
     }
@@ -625,6 +663,76 @@ sval_t ccavl<skey_t, sval_t, RecMgr>::attemptGet(skey_t key,
     }
 }
 
+//////// ordered search
+
+// reads the child of parent in direction dir hand-over-hand (its version, then
+// the link again) and records it. returns false if the lookup must start over.
+template <typename skey_t, typename sval_t, class RecMgr>
+bool ccavl<skey_t, sval_t, RecMgr>::navVisit(const int tid, node_t<skey_t, sval_t>* parent, char dir, node_t<skey_t, sval_t>** child) {
+    node_t<skey_t, sval_t>* c = get_child(parent, dir);
+    *child = c;
+    if (c == NULL) return true;
+    version_t ovl = c->changeOVL;
+    if (isShrinkingOrUnlinked(ovl)) {
+        waitUntilChangeCompleted(c, ovl);
+        return false;
+    }
+    SOFTWARE_BARRIER;
+    if (get_child(parent, dir) != c) return false;
+    navThreadData[tid].nodes.push_back(std::make_pair(c, ovl));
+    return true;
+}
+
+// finds the node with a value and the largest key <= key (!forward), or the
+// smallest key >= key (forward and inclusive) or > key, in the subtree of
+// parent in direction dir (any key if !bounded). *outValue is NULL if there is
+// none. returns false if the lookup must start over.
+template <typename skey_t, typename sval_t, class RecMgr>
+bool ccavl<skey_t, sval_t, RecMgr>::navSearch(const int tid, node_t<skey_t, sval_t>* parent, char dir, skey_t key, bool bounded,
+        const bool forward, const bool inclusive, skey_t * const outKey, sval_t * const outValue) {
+    const char nearDir = forward ? LEFT : RIGHT;   // the side of the keys closest to key
+    const char farDir = forward ? RIGHT : LEFT;
+    node_t<skey_t, sval_t>* curr;
+    *outValue = NULL;
+    if (!navVisit(tid, parent, dir, &curr)) return false;
+    while (curr != NULL) {
+        const bool qualifies = !bounded || (forward ? (inclusive ? !(curr->key < key) : key < curr->key) : !(key < curr->key));
+        if (qualifies) {
+            if (!navSearch(tid, curr, nearDir, key, bounded, forward, inclusive, outKey, outValue)) return false;
+            if (*outValue != NULL) return true;
+            sval_t value = curr->value;
+            if (value != NULL) {
+                *outKey = curr->key;
+                *outValue = value;
+                return true;
+            }
+            // every key on the far side qualifies
+            bounded = false;
+        }
+        if (!navVisit(tid, curr, farDir, &curr)) return false;
+    }
+    return true;
+}
+
+template <typename skey_t, typename sval_t, class RecMgr>
+sval_t ccavl<skey_t, sval_t, RecMgr>::navigate(const int tid, skey_t key, const bool forward, const bool inclusive, skey_t * const outKey) {
+    auto guard = recmgr->getGuard(tid, true);
+    std::vector<std::pair<node_t<skey_t, sval_t>*, version_t> >& nodes = navThreadData[tid].nodes;
+    while (true) {
+        nodes.clear();
+        sval_t value;
+        if (!navSearch(tid, root, RIGHT, key, true, forward, inclusive, outKey, &value)) continue;
+        bool valid = true;
+        for (auto& n : nodes) {
+            if (hasShrunkOrUnlinked(n.second, n.first->changeOVL)) {
+                valid = false;
+                break;
+            }
+        }
+        if (valid) return decodeNull(value);
+    }
+}
+
 template <typename skey_t, typename sval_t, class RecMgr>
 int ccavl<skey_t, sval_t, RecMgr>::shouldUpdate(int func, sval_t prev, sval_t expected) {
     switch (func) {
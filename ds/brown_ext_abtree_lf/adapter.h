@@ -20,10 +20,19 @@
 #if !defined FAT_NODE_DEGREE
     #define FAT_NODE_DEGREE 11
 #endif
+// the degrees of internal nodes and of leaves can be set separately (e.g.,
+// make abtree_degrees=16,8), and nodes have room for the larger one
+#if !defined ABTREE_INTERNAL_DEGREE
+    #define ABTREE_INTERNAL_DEGREE FAT_NODE_DEGREE
+#endif
+#if !defined ABTREE_LEAF_DEGREE
+    #define ABTREE_LEAF_DEGREE FAT_NODE_DEGREE
+#endif
+#define ABTREE_NODE_DEGREE (ABTREE_INTERNAL_DEGREE > ABTREE_LEAF_DEGREE ? ABTREE_INTERNAL_DEGREE : ABTREE_LEAF_DEGREE)
 
-#define NODE_T abtree_ns::Node<FAT_NODE_DEGREE, K>
+#define NODE_T abtree_ns::Node<ABTREE_NODE_DEGREE, K>
 #define RECORD_MANAGER_T record_manager<Reclaim, Alloc, Pool, NODE_T>
-#define DATA_STRUCTURE_T abtree_ns::abtree<FAT_NODE_DEGREE, K, std::less<K>, RECORD_MANAGER_T>
+#define DATA_STRUCTURE_T abtree_ns::abtree<ABTREE_NODE_DEGREE, K, std::less<K>, RECORD_MANAGER_T, ABTREE_INTERNAL_DEGREE, ABTREE_LEAF_DEGREE>
 
 template <typename K, typename V, class Reclaim = reclaimer_debra<K>, class Alloc = allocator_new<K>, class Pool = pool_none<K>>
 class ds_adapter {
@@ -63,6 +72,7 @@ public:
     bool contains(const int tid, const K& key) {
         return ds->contains(tid, key);
     }
+    #define DS_ADAPTER_SUPPORTS_INSERT_REPLACE
     V insert(const int tid, const K& key, const V& val) {
         return (V) ds->insert(tid, key, val);
     }
@@ -75,8 +85,60 @@ public:
     V find(const int tid, const K& key) {
         return (V) ds->find(tid, key).first;
     }
-    int rangeQuery(const int tid, const K& lo, const K& hi, K * const resultKeys, V * const resultValues) {
-        return ds->rangeQuery(tid, lo, hi, resultKeys, (void ** const) resultValues);
+    // returns at most capacity keys, the first ones of [lo, hi]. linearizable,
+    // unless built with RQ_UNSAFE (see abtree::rangeQuery)
+    #define DS_ADAPTER_SUPPORTS_RANGE_QUERY
+    int rangeQuery(const int tid, const K& lo, const K& hi, K * const resultKeys, V * const resultValues, const int capacity) {
+        return ds->rangeQuery(tid, lo, hi, resultKeys, (void ** const) resultValues, capacity);
+    }
+    // the value of the largest key <= key (predecessor), the smallest key > key
+    // (successor) or the smallest key >= key (lowerBound), and that key in
+    // outKey, or getNoValue() if there is none. linearizable (see abtree::predecessor)
+    #define DS_ADAPTER_SUPPORTS_ORDERED_SEARCH
+    V predecessor(const int tid, const K& key, K * const outKey) {
+        return (V) ds->predecessor(tid, key, outKey).first;
+    }
+    V successor(const int tid, const K& key, K * const outKey) {
+        return (V) ds->successor(tid, key, outKey).first;
+    }
+    V lowerBound(const int tid, const K& key, K * const outKey) {
+        return (V) ds->lowerBound(tid, key, outKey).first;
+    }
+    // a weakly consistent forward cursor for thread tid, which continues from
+    // its last leaf instead of the root. while it is open, the thread must not
+    // call other operations (see abtree::Cursor)
+    #define DS_ADAPTER_SUPPORTS_CURSOR
+    class Cursor {
+    private:
+        typename DATA_STRUCTURE_T::Cursor c;
+    public:
+        Cursor(ds_adapter * const adapter, const int tid) : c(adapter->ds, tid) {}
+        void seek(const K& key) { c.seek(key); }
+        bool valid() { return c.valid(); }
+        K key() { return c.key(); }
+        V value() { return (V) c.value(); }
+        void next() { c.next(); }
+        void close() { c.close(); }
+    };
+    // insertIfAbsent and find of n keys at once: the batch is sorted, and the
+    // keys that fall in the same leaf share its descent, and for inserts, one
+    // new leaf and SCX (see abtree::insertBatch). insertBatch returns how many
+    // keys it inserted, and findBatch how many it found (with getNoValue() as
+    // the value of the others)
+    #define DS_ADAPTER_SUPPORTS_BATCH
+    int insertBatch(const int tid, const K * const keys, const V * const values, const int n) {
+        return ds->insertBatch(tid, keys, (void * const *) values, n);
+    }
+    int findBatch(const int tid, const K * const keys, const int n, V * const values) {
+        return ds->findBatch(tid, keys, n, (void ** const) values);
+    }
+    // keys are only compared (with <) and copied, so K can be a struct like
+    // the str_key of bench/string_keys.h
+    #define DS_ADAPTER_SUPPORTS_STRING_KEYS
+    #define DS_ADAPTER_SUPPORTS_BULK_LOAD
+    // builds the tree from n strictly increasing keys (see abtree::bulkLoad)
+    void bulkLoad(const int numThreads, const K * const keys, const V * const values, const size_t n, const double fillFactor) {
+        ds->bulkLoad(numThreads, keys, (void * const *) values, n, fillFactor);
     }
     void printSummary() {
         ds->debugGetRecMgr()->printStatus();
@@ -85,12 +147,20 @@ public:
         return true;
     }
     void printObjectSizes() {
-        std::cout<<"size_node="<<(sizeof(abtree_ns::Node<FAT_NODE_DEGREE, K>))<<std::endl;
+        std::cout<<"size_node="<<(sizeof(NODE_T))<<" internal_degree="<<ABTREE_INTERNAL_DEGREE<<" leaf_degree="<<ABTREE_LEAF_DEGREE<<std::endl;
     }
     // try to clean up: must only be called by a single thread as part of the test harness!
     void debugGCSingleThreaded() {
         ds->debugGetRecMgr()->debugGCSingleThreaded();
     }
+    #define DS_ADAPTER_SUPPORTS_MEMORY_STATS
+    // the size of a node, how many nodes are allocated and not yet freed, how
+    // many of those are retired and waiting to be reclaimed, and how many have
+    // been freed (may be called during a run, see record_manager::getMemoryStats)
+    void getMemoryStats(size_t * const nodeBytes, long long * const outstanding, long long * const limbo, long long * const freed) {
+        *nodeBytes = sizeof(NODE_T);
+        ds->debugGetRecMgr()->getMemoryStats((NODE_T *) NULL, outstanding, limbo, freed);
+    }
 
     size_t size() {
         return ds->sequentialSize();
@@ -41,13 +41,26 @@
 #define	ABTREE_H
 
 #include <string>
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <set>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <functional>
+#include <type_traits>
+#include <climits>
 #include <unistd.h>
 #include <sys/types.h>
+#ifdef ABTREE_SIMD_SEARCH
+#if !defined(__AVX2__) && !defined(__AVX512F__)
+#error "ABTREE_SIMD_SEARCH needs AVX2 or AVX-512 (e.g., make simd=avx2)"
+#endif
+#include <immintrin.h>
+#endif
 #include "record_manager.h"
 #include "prefetching.h"
 #include "scx_provider.h"
@@ -71,16 +84,135 @@ namespace abtree_ns {
 
     #define ABTREE_ENABLE_DESTRUCTOR
 
+    /**
+     * Search within the sorted keys of a node. countBefore returns how many of
+     * the first nkeys keys cmp orders before key, and countNotAfter how many
+     * are not ordered after it, i.e., the index of the first key >= key and of
+     * the first key > key.
+     *
+     * The generic version walks the keys with the comparator, with a branch on
+     * every key. Built with ABTREE_SIMD_SEARCH (make simd=avx2 or simd=avx512),
+     * std::less on 4 and 8 byte integers compares the keys a vector at a time
+     * and counts the matches with popcount, without branching on the keys.
+     * Keys past nkeys are never read: AVX-512 masks them out of the loads, and
+     * AVX2 counts the last few keys one at a time.
+     *
+     * The vector search is not the default. It removes the mispredictions,
+     * but the child pointer then depends on all keys of the node, while the
+     * branchy search lets the CPU speculate down the tree and overlap cache
+     * misses.
+     */
+    template <typename K, class Compare, class Enable = void>
+    struct NodeSearch {
+        static inline int countBefore(const K * keys, const int nkeys, const K& key, Compare cmp) {
+            int retval = 0;
+            while (retval < nkeys && cmp(keys[retval], key)) {
+                ++retval;
+            }
+            return retval;
+        }
+        static inline int countNotAfter(const K * keys, const int nkeys, const K& key, Compare cmp) {
+            int retval = 0;
+            while (retval < nkeys && !cmp(key, keys[retval])) {
+                ++retval;
+            }
+            return retval;
+        }
+    };
+
+#ifdef ABTREE_SIMD_SEARCH
+    template <typename K>
+    struct NodeSearch<K, std::less<K>, typename std::enable_if<std::is_integral<K>::value && (sizeof(K) == 4 || sizeof(K) == 8)>::type> {
+        // the number of keys greater than key (GREATER) or less than key (!GREATER) among the first nkeys
+        template <bool GREATER>
+        static inline int count(const K * keys, const int nkeys, const K key) {
+            int result = 0;
+#ifdef __AVX512F__
+            const int LANES = 64 / sizeof(K);
+            for (int i = 0; i < nkeys; i += LANES) {
+                const int left = nkeys - i;
+                if (sizeof(K) == 8) {
+                    const __mmask8 m = (left >= LANES) ? (__mmask8) 0xff : (__mmask8) ((1u << left) - 1);
+                    const __m512i v = _mm512_maskz_loadu_epi64(m, keys + i);
+                    const __m512i k = _mm512_set1_epi64((long long) key);
+                    __mmask8 c;
+                    if (std::is_signed<K>::value) c = GREATER ? _mm512_mask_cmpgt_epi64_mask(m, v, k) : _mm512_mask_cmplt_epi64_mask(m, v, k);
+                    else c = GREATER ? _mm512_mask_cmpgt_epu64_mask(m, v, k) : _mm512_mask_cmplt_epu64_mask(m, v, k);
+                    result += __builtin_popcount(c);
+                } else {
+                    const __mmask16 m = (left >= LANES) ? (__mmask16) 0xffff : (__mmask16) ((1u << left) - 1);
+                    const __m512i v = _mm512_maskz_loadu_epi32(m, keys + i);
+                    const __m512i k = _mm512_set1_epi32((int) key);
+                    __mmask16 c;
+                    if (std::is_signed<K>::value) c = GREATER ? _mm512_mask_cmpgt_epi32_mask(m, v, k) : _mm512_mask_cmplt_epi32_mask(m, v, k);
+                    else c = GREATER ? _mm512_mask_cmpgt_epu32_mask(m, v, k) : _mm512_mask_cmplt_epu32_mask(m, v, k);
+                    result += __builtin_popcount(c);
+                }
+            }
+            return result;
+#else
+            // AVX2 only compares signed integers: unsigned keys are compared with their top bit flipped
+            const int LANES = 32 / sizeof(K);
+            int i = 0;
+            if (sizeof(K) == 8) {
+                const __m256i flip = _mm256_set1_epi64x(std::is_signed<K>::value ? 0 : LLONG_MIN);
+                const __m256i k = _mm256_xor_si256(_mm256_set1_epi64x((long long) key), flip);
+                for (; i + LANES <= nkeys; i += LANES) {
+                    const __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (keys + i)), flip);
+                    const __m256i c = GREATER ? _mm256_cmpgt_epi64(v, k) : _mm256_cmpgt_epi64(k, v);
+                    result += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(c)));
+                }
+            } else {
+                const __m256i flip = _mm256_set1_epi32(std::is_signed<K>::value ? 0 : INT_MIN);
+                const __m256i k = _mm256_xor_si256(_mm256_set1_epi32((int) key), flip);
+                for (; i + LANES <= nkeys; i += LANES) {
+                    const __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (keys + i)), flip);
+                    const __m256i c = GREATER ? _mm256_cmpgt_epi32(v, k) : _mm256_cmpgt_epi32(k, v);
+                    result += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(c)));
+                }
+            }
+            for (; i < nkeys; ++i) {
+                result += GREATER ? (keys[i] > key) : (keys[i] < key);
+            }
+            return result;
+#endif
+        }
+        static inline int countBefore(const K * keys, const int nkeys, const K& key, std::less<K> cmp) {
+            return count<false>(keys, nkeys, key);
+        }
+        static inline int countNotAfter(const K * keys, const int nkeys, const K& key, std::less<K> cmp) {
+            return nkeys - count<true>(keys, nkeys, key);
+        }
+    };
+#endif
+
+    /**
+     * The fields a search reads come first: size and leaf, then the keys, so
+     * that a search of a node with k keys reads the first 8 + k*sizeof(K)
+     * bytes, and the pointer it follows. The fields that only updates read
+     * (the SCX handle, marked, weight and searchKey) come after the pointers.
+     * With 8-byte keys, a node takes 32 + 16*DEGREE bytes, a whole number of
+     * cache lines when DEGREE is 2 mod 4 (e.g., 14 in 4 lines).
+     *
+     * The node type is not aligned itself: allocator_once and allocator_bump
+     * place records on cache line boundaries, while allocator_new gets the
+     * 16-byte alignment of malloc.
+     *
+     * DEGREE is the capacity of the arrays. Internal nodes and leaves are the
+     * same type (for the record manager and the SCX provider), so a tree whose
+     * leaves and internal nodes have different degrees (see abtree) uses the
+     * larger one as DEGREE.
+     */
     template <int DEGREE, typename K>
     struct Node {
-        scx_handle_t volatile scxPtr;
+        int size; // degree of node
         int leaf; // 0 or 1
+        K keys[DEGREE];
+        Node<DEGREE,K> * volatile ptrs[DEGREE];
+        scx_handle_t volatile scxPtr;
         volatile int marked; // 0 or 1
         int weight; // 0 or 1
-        int size; // degree of node
         K searchKey;
-        K keys[DEGREE];
-        Node<DEGREE,K> * volatile ptrs[DEGREE];
 
         inline bool isLeaf() {
             return leaf;
@@ -93,26 +225,20 @@ namespace abtree_ns {
         }
         template <class Compare>
         inline int getChildIndex(const K& key, Compare cmp) {
-            int nkeys = getKeyCount();
-            int retval = 0;
-            while (retval < nkeys && !cmp(key, (const K&) keys[retval])) {
-                ++retval;
-            }
-            return retval;
+            return NodeSearch<K, Compare>::countNotAfter(keys, getKeyCount(), key, cmp);
         }
         template <class Compare>
         inline int getKeyIndex(const K& key, Compare cmp) {
-            int nkeys = getKeyCount();
-            int retval = 0;
-            while (retval < nkeys && cmp((const K&) keys[retval], key)) {
-                ++retval;
-            }
-            return retval;
+            return NodeSearch<K, Compare>::countBefore(keys, getKeyCount(), key, cmp);
         }
     };
 
-    template <int DEGREE, typename K, class Compare, class RecManager>
+    // internal nodes have up to INTERNAL_DEGREE children, and leaves up to
+    // LEAF_DEGREE keys, both at most the capacity DEGREE of Node<DEGREE,K>
+    template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE = DEGREE, int LEAF_DEGREE = DEGREE>
     class abtree {
+        static_assert(INTERNAL_DEGREE <= DEGREE && LEAF_DEGREE <= DEGREE, "the degrees of internal nodes and leaves must fit in Node<DEGREE,K>");
+        static_assert(INTERNAL_DEGREE >= 4 && LEAF_DEGREE >= 4, "the degrees of internal nodes and leaves must be at least 4");
     private:
         // the following bool determines whether the optimization to guarantee
         // amortized constant rebalancing (at the cost of decreasing average degree
@@ -122,8 +248,9 @@ namespace abtree_ns {
         PAD;
         const bool ALLOW_ONE_EXTRA_SLACK_PER_NODE;
 
-        const int b;
-        const int a;
+        // the smallest degree of a node other than the root (b is INTERNAL_DEGREE or LEAF_DEGREE)
+        const int aInternal;
+        const int aLeaf;
 
         RecManager * const recordmgr;
         SCXProvider<Node<DEGREE,K>, MAX_NODE_DEPENDENCIES_PER_SCX> * const prov;
@@ -153,6 +280,46 @@ namespace abtree_ns {
 
         Node<DEGREE,K>* allocateNode(const int tid);
 
+        // a leaf a range query read, and where: parent->ptrs[ix]
+        struct RQLeaf {
+            Node<DEGREE,K> * parent;
+            int ix;
+            Node<DEGREE,K> * leaf;
+        };
+        struct RQThreadData {
+            std::vector<RQLeaf> leaves;
+            PAD;
+        };
+        RQThreadData * const rqThreadData;
+
+        void rqCollect(const int tid, Node<DEGREE,K> * parent, const int ix, const K& lo, const K& hi, K * const resultKeys, void ** const resultValues, const int capacity, int * const size);
+        bool rqValidate(const int tid);
+        Node<DEGREE,K> * rqDescend(const int tid, const K& key, const bool below, const bool forward, K * const bound, bool * const hasBound);
+        const std::pair<void*,bool> navigate(const int tid, const K& key, const bool forward, const bool inclusive, K * const outKey);
+
+        // the nodes a batch descended through: entry, then the internal nodes
+        // down to the parent of the last leaf, each with where its range ends
+        struct BatchStep {
+            Node<DEGREE,K> * node;
+            K hi;
+            bool hasHi;
+        };
+        struct BatchThreadData {
+            std::vector<int> order;                 // the indices of the batch, in key order
+            std::vector<BatchStep> path;
+            std::vector<K> keys;                    // the keys and values of the leaves insertBatch builds
+            std::vector<Node<DEGREE,K> *> values;
+            PAD;
+        };
+        BatchThreadData * const batchThreadData;
+
+        void batchSort(const int tid, const K * const keys, const int n, const bool dedupe);
+        Node<DEGREE,K> * batchDescend(const int tid, const K& key, int * const ixToL, K * const hi, bool * const hasHi);
+
+        inline int minDegree(Node<DEGREE,K>* node) {
+            return node->isLeaf() ? aLeaf : aInternal;
+        }
+
         void freeSubtree(Node<DEGREE,K>* node, int* nodes) {
             const int tid = 0;
             if (node == NULL) return;
@@ -190,18 +357,20 @@ public:
 
         /**
          * Creates a new relaxed (a,b)-tree wherein: <br>
-         *      each internal node has up to <code>DEGREE</code> child pointers, and <br>
-         *      each leaf has up to <code>DEGREE</code> key/value pairs, and <br>
+         *      each internal node has up to <code>INTERNAL_DEGREE</code> child pointers, and <br>
+         *      each leaf has up to <code>LEAF_DEGREE</code> key/value pairs, and <br>
          *      keys are ordered according to the provided comparator.
          */
         abtree(const int numProcesses,
                 const K anyKey,
                 int suspectedCrashSignal = SIGQUIT)
         : ALLOW_ONE_EXTRA_SLACK_PER_NODE(true)
-        , b(DEGREE)
-        , a(std::max(DEGREE/4, 2))
+        , aInternal(std::max(INTERNAL_DEGREE/4, 2))
+        , aLeaf(std::max(LEAF_DEGREE/4, 2))
         , recordmgr(new RecManager(numProcesses, suspectedCrashSignal))
         , prov(new SCXProvider<Node<DEGREE,K>, MAX_NODE_DEPENDENCIES_PER_SCX>(numProcesses))
+        , rqThreadData(new RQThreadData[numProcesses])
+        , batchThreadData(new BatchThreadData[numProcesses])
         , NO_VALUE((void *) -1LL)
         , NUM_PROCESSES(numProcesses)
         {
@@ -234,6 +403,8 @@ public:
             freeSubtree(entry, &nodes);
 //            COUTATOMIC("main thread: deleted tree containing "<<nodes<<" nodes"<<std::endl);
             delete prov;
+            delete[] rqThreadData;
+            delete[] batchThreadData;
 //            recordmgr->printStatus();
             delete recordmgr;
         }
@@ -351,7 +522,7 @@ public:
             return getTotalDegree(entry) / (double) getNodeCount(entry);
         }
         double getSpacePerKey() {
-            return getNodeCount(entry)*2*b / (double) getKeyCount(entry);
+            return getNodeCount(entry)*2*DEGREE / (double) getKeyCount(entry);
         }
 
         long long getSumOfKeys(Node<DEGREE,K>* node) {
@@ -400,7 +571,216 @@ public:
         const std::pair<void*,bool> erase(const int tid, const K& key);
         const std::pair<void*,bool> find(const int tid, const K& key);
         bool contains(const int tid, const K& key);
-        int rangeQuery(const int tid, const K& low, const K& hi, K * const resultKeys, void ** const resultValues);
+
+        /**
+         * Writes the keys in [low, hi] and their values to resultKeys and
+         * resultValues, in increasing order, and returns how many there are.
+         * The arrays must have room for all of them.
+         *
+         * The query descends only into the children whose key ranges overlap
+         * [low, hi], and copies the keys in range out of each leaf it reaches
+         * (at most LEAF_DEGREE per leaf). Leaves are immutable, and a leaf
+         * keeps its key range for as long as it is in the tree, so the copied
+         * keys are exactly the contents of the range at any moment at which
+         * all of these leaves are in the tree. After the copy, the query
+         * checks that every leaf is still a child of its parent, and that the
+         * parent is not marked (removed nodes are marked before they are
+         * unlinked). If so, all leaves were in the tree when the copy ended,
+         * which is where the query is linearized. Otherwise, an update changed
+         * the range in the meantime, and the query starts over. Under a high
+         * update rate, long ranges can therefore retry many times.
+         *
+         * At most capacity keys are returned: once the buffers are full, the
+         * query stops descending and checks only the leaves it has read, so
+         * the result is the first capacity keys of the range at the
+         * linearization point.
+         *
+         * Built with RQ_UNSAFE (make rq=unsafe), the query skips the check and
+         * returns the keys of the leaves it read, which is not linearizable:
+         * it may miss a key that was in the range throughout, or return keys
+         * that were never in the range at the same time.
+         */
+        int rangeQuery(const int tid, const K& low, const K& hi, K * const resultKeys, void ** const resultValues, const int capacity);
+
+        /**
+         * Ordered lookups: predecessor finds the largest key <= key, successor
+         * the smallest key > key, and lowerBound the smallest key >= key. They
+         * return its value and true, and write the key to outKey, or return
+         * (NO_VALUE, false) if there is no such key.
+         *
+         * A lookup descends to the leaf whose range contains key, as find does,
+         * and is done if the answer is in that leaf. Otherwise, it descends
+         * again to the leaf just before (or after) the range of that leaf, and
+         * so on past empty leaves. When it read more than one leaf, it checks
+         * them as rangeQuery does (each is still the child of an unmarked
+         * parent), and starts over if one was replaced, so that the leaves it
+         * read partition one contiguous range at one moment. Lookups are
+         * therefore linearizable, also when built with RQ_UNSAFE.
+         */
+        const std::pair<void*,bool> predecessor(const int tid, const K& key, K * const outKey) {
+            return navigate(tid, key, false, true, outKey);
+        }
+        const std::pair<void*,bool> successor(const int tid, const K& key, K * const outKey) {
+            return navigate(tid, key, true, false, outKey);
+        }
+        const std::pair<void*,bool> lowerBound(const int tid, const K& key, K * const outKey) {
+            return navigate(tid, key, true, true, outKey);
+        }
+
+        /**
+         * A forward cursor over the keys of the tree, for one thread:
+         *
+         *      Cursor c(tree, tid);
+         *      for (c.seek(lo); c.valid() && !cmp(hi, c.key()); c.next()) ...
+         *      c.close();
+         *
+         * seek positions the cursor at the smallest key >= key. The cursor
+         * keeps the path from the entry to its leaf, so next is a step within
+         * the leaf, and at the end of a leaf it climbs to the deepest ancestor
+         * with a next child and descends along the leftmost children from
+         * there, instead of from the root. Each node on the way is checked to
+         * be unmarked after its child pointer is read, so that the child was
+         * in the tree. If a node was marked (removed), the cursor descends
+         * again from the root to the end of the leaf it left.
+         *
+         * The cursor is weakly consistent: it returns keys in increasing order,
+         * each of them was in the tree while the cursor read its leaf, and a key
+         * that stays in the tree while the cursor passes its position is
+         * returned. It is not a snapshot (use rangeQuery for that).
+         *
+         * Between seek and close (or the destructor), the cursor holds the
+         * thread in a read-only operation of the record manager, which keeps
+         * the nodes it points to from being freed, and delays reclamation for
+         * all threads as long as it is open. The thread must not invoke other
+         * operations of the tree while its cursor is open, as they would end
+         * that operation.
+         */
+        class Cursor {
+        private:
+            struct Step {
+                Node<DEGREE,K> * node;
+                int ix;
+            };
+            abtree * const tree;
+            const int tid;
+            std::vector<Step> path; // path[i].node->ptrs[path[i].ix] was path[i+1].node, or leaf
+            Node<DEGREE,K> * leaf;  // NULL past the last key
+            int pos;
+            bool open;
+
+            void descend(const K& key) {
+                path.clear();
+                Node<DEGREE,K> * node = tree->entry;
+                path.push_back({node, 0});
+                Node<DEGREE,K> * l = node->ptrs[0];
+                while (!l->isLeaf()) {
+                    const int ix = l->getChildIndex(key, tree->cmp);
+                    path.push_back({l, ix});
+                    l = l->ptrs[ix];
+                }
+                leaf = l;
+                pos = l->getKeyIndex(key, tree->cmp);
+            }
+            // moves to the first key of the next leaf, or past the end
+            void nextLeaf() {
+                int d = (int) path.size() - 1;
+                while (d >= 0 && path[d].ix + 1 >= path[d].node->getABDegree()) --d;
+                if (d < 0) {
+                    leaf = NULL;
+                    return;
+                }
+                const K hi = path[d].node->keys[path[d].ix]; // where the old leaf's range ends
+                path.resize(d + 1);
+                Node<DEGREE,K> * node = path[d].node;
+                Node<DEGREE,K> * child = node->ptrs[++path[d].ix];
+                while (true) {
+                    SOFTWARE_BARRIER; // read the pointer before marked
+                    if (node->marked) {
+                        descend(hi);
+                        return;
+                    }
+                    if (child->isLeaf()) break;
+                    path.push_back({child, 0});
+                    node = child;
+                    child = child->ptrs[0];
+                }
+                leaf = child;
+                pos = 0;
+            }
+            // skips past the end of the leaf, and empty leaves
+            void settle() {
+                while (leaf != NULL && pos >= leaf->getKeyCount()) nextLeaf();
+            }
+
+        public:
+            Cursor(abtree * const _tree, const int _tid)
+            : tree(_tree), tid(_tid), leaf(NULL), pos(0), open(false) {}
+            ~Cursor() {
+                close();
+            }
+            void seek(const K& key) {
+                if (!open) {
+                    tree->recordmgr->startOp(tid, true);
+                    open = true;
+                }
+                descend(key);
+                settle();
+            }
+            bool valid() {
+                return leaf != NULL;
+            }
+            const K& key() {
+                return leaf->keys[pos];
+            }
+            void * value() {
+                return leaf->ptrs[pos];
+            }
+            void next() {
+                ++pos;
+                settle();
+            }
+            void close() {
+                if (!open) return;
+                leaf = NULL;
+                open = false;
+                tree->recordmgr->endOp(tid);
+            }
+        };
+
+        /**
+         * Batched operations on n keys in any order. insertBatch inserts each
+         * key that is absent with its value (as insertIfAbsent; of equal keys,
+         * the first is inserted) and returns how many it inserted. findBatch
+         * writes the value of each key to values (NO_VALUE if it is absent)
+         * and returns how many it found.
+         *
+         * Both sort the batch, and keep the path of their last descent: the
+         * next key starts from the deepest node on it whose range contains
+         * the key, instead of from the root, and all keys in the range of a
+         * leaf are handled at that leaf. insertBatch merges them with the keys
+         * of the leaf, and replaces it with one SCX, by one new leaf, or if
+         * they do not fit, by a new internal node with as few full leaves as
+         * hold them (at most INTERNAL_DEGREE leaves: keys beyond that wait for
+         * the next round), which rebalancing then absorbs into the parent as
+         * after an overflow. If the SCX fails, the leaf is retried from the
+         * root.
+         *
+         * Each key is linearized separately, at the SCX that inserted it, or at
+         * the read of its leaf. A batch is one operation of the record manager,
+         * which delays reclamation for all threads until it returns, so batches
+         * of a few thousand keys are plenty.
+         */
+        int insertBatch(const int tid, const K * const keys, void * const * const values, const int n);
+        int findBatch(const int tid, const K * const keys, const int n, void ** const values);
+
+        /**
+         * Replaces the (empty) tree by one that contains the n given keys, which
+         * must be strictly increasing, with the given values. Leaves and internal
+         * nodes are filled to about fillFactor times their degree, and each level is built
+         * bottom-up by numThreads threads (with tids 0..numThreads-1, so at most
+         * numProcesses). Must not run concurrently with any other operation.
+         */
+        void bulkLoad(const int numThreads, const K * const keys, void * const * const values, const size_t n, const double fillFactor);
         bool validate(const long long keysum, const bool checkkeysum) {
             if (checkkeysum) {
                 long long treekeysum = getSumOfKeys();
@@ -435,8 +815,8 @@ public:
     };
 } // namespace
 
-template <int DEGREE, typename K, class Compare, class RecManager>
-abtree_ns::Node<DEGREE,K> * abtree_ns::abtree<DEGREE,K,Compare,RecManager>::allocateNode(const int tid) {
+template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE, int LEAF_DEGREE>
+abtree_ns::Node<DEGREE,K> * abtree_ns::abtree<DEGREE,K,Compare,RecManager,INTERNAL_DEGREE,LEAF_DEGREE>::allocateNode(const int tid) {
     Node<DEGREE,K> *newnode = recordmgr->template allocate<Node<DEGREE,K> >(tid);
     if (newnode == NULL) {
         COUTATOMICTID("ERROR: could not allocate node"<<std::endl);
@@ -449,8 +829,8 @@ abtree_ns::Node<DEGREE,K> * abtree_ns::abtree<DEGREE,K,Compare,RecManager>::allo
     return newnode;
 }
 
-template <int DEGREE, typename K, class Compare, class RecManager>
-const std::pair<void*,bool> abtree_ns::abtree<DEGREE,K,Compare,RecManager>::find(const int tid, const K& key) {
+template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE, int LEAF_DEGREE>
+const std::pair<void*,bool> abtree_ns::abtree<DEGREE,K,Compare,RecManager,INTERNAL_DEGREE,LEAF_DEGREE>::find(const int tid, const K& key) {
     std::pair<void*,bool> result;
     auto guard = recordmgr->getGuard(tid, true);
     Node<DEGREE,K> * l = entry->ptrs[0];
@@ -469,19 +849,421 @@ const std::pair<void*,bool> abtree_ns::abtree<DEGREE,K,Compare,RecManager>::find
     return result;
 }
 
-template <int DEGREE, typename K, class Compare, class RecManager>
-bool abtree_ns::abtree<DEGREE,K,Compare,RecManager>::contains(const int tid, const K& key) {
+template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE, int LEAF_DEGREE>
+bool abtree_ns::abtree<DEGREE,K,Compare,RecManager,INTERNAL_DEGREE,LEAF_DEGREE>::contains(const int tid, const K& key) {
     return find(tid, key).second;
 }
 
-template<int DEGREE, typename K, class Compare, class RecManager>
-int abtree_ns::abtree<DEGREE,K,Compare,RecManager>::rangeQuery(const int tid, const K& lo, const K& hi, K * const resultKeys, void ** const resultValues) {
-    setbench_error("not implemented");
+template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE, int LEAF_DEGREE>
+int abtree_ns::abtree<DEGREE,K,Compare,RecManager,INTERNAL_DEGREE,LEAF_DEGREE>::rangeQuery(const int tid, const K& lo, const K& hi, K * const resultKeys, void ** const resultValues, const int capacity) {
+    auto guard = recordmgr->getGuard(tid, true);
+    int size;
+    do {
+        size = 0;
+        rqThreadData[tid].leaves.clear();
+        rqCollect(tid, entry, 0, lo, hi, resultKeys, resultValues, capacity, &size);
+    } while (!rqValidate(tid));
+    return size;
+}
+
+// copies the keys in [lo, hi] of the leaves below parent->ptrs[ix], in order,
+// until *size reaches capacity, and records each leaf it reads for rqValidate
+template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE, int LEAF_DEGREE>
+void abtree_ns::abtree<DEGREE,K,Compare,RecManager,INTERNAL_DEGREE,LEAF_DEGREE>::rqCollect(const int tid, Node<DEGREE,K> * parent, const int ix, const K& lo, const K& hi, K * const resultKeys, void ** const resultValues, const int capacity, int * const size) {
+    Node<DEGREE,K> * node = parent->ptrs[ix];
+    if (node->isLeaf()) {
+#if !defined RQ_UNSAFE
+        rqThreadData[tid].leaves.push_back({parent, ix, node});
+#endif
+        const int nkeys = node->getKeyCount();
+        for (int i=node->getKeyIndex(lo, cmp);i<nkeys && *size<capacity && !cmp(hi, node->keys[i]);++i) {
+            resultKeys[*size] = node->keys[i];
+            resultValues[*size] = node->ptrs[i];
+            ++(*size);
+        }
+        return;
+    }
+    const int last = node->getChildIndex(hi, cmp);
+    for (int i=node->getChildIndex(lo, cmp);i<=last && *size<capacity;++i) {
+        rqCollect(tid, node, i, lo, hi, resultKeys, resultValues, capacity, size);
+    }
+}
+
+// returns true if every leaf the range query (or ordered lookup) read is still
+// a child of an unmarked parent. a marked parent has been (or is about to be)
+// removed, and an unmarked one is in the tree, as is then the leaf it points to.
+// (with RQ_UNSAFE, range queries record no leaves.)
+template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE, int LEAF_DEGREE>
+bool abtree_ns::abtree<DEGREE,K,Compare,RecManager,INTERNAL_DEGREE,LEAF_DEGREE>::rqValidate(const int tid) {
+    for (const RQLeaf& r : rqThreadData[tid].leaves) {
+        if (r.parent->ptrs[r.ix] != r.leaf) return false;
+        SOFTWARE_BARRIER; // read the pointer before marked
+        if (r.parent->marked) return false;
+    }
+    return true;
+}
+
+// descends to the leaf whose range contains key (or, if below, the leaf whose
+// range ends at or after key and starts before it), records it for rqValidate,
+// and sets bound to where its range ends (forward) or starts (!forward), if the
+// range is bounded on that side
+template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE, int LEAF_DEGREE>
+abtree_ns::Node<DEGREE,K> * abtree_ns::abtree<DEGREE,K,Compare,RecManager,INTERNAL_DEGREE,LEAF_DEGREE>::rqDescend(const int tid, const K& key, const bool below, const bool forward, K * const bound, bool * const hasBound) {
+    *hasBound = false;
+    Node<DEGREE,K> * parent = entry;
+    int ix = 0;
+    Node<DEGREE,K> * node = parent->ptrs[0];
+    while (!node->isLeaf()) {
+        parent = node;
+        ix = below ? node->getKeyIndex(key, cmp) : node->getChildIndex(key, cmp);
+        if (forward && ix < node->getKeyCount()) {
+            *bound = node->keys[ix];
+            *hasBound = true;
+        } else if (!forward && ix > 0) {
+            *bound = node->keys[ix-1];
+            *hasBound = true;
+        }
+        node = node->ptrs[ix];
+    }
+    rqThreadData[tid].leaves.push_back({parent, ix, node});
+    return node;
+}
+
+template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE, int LEAF_DEGREE>
+const std::pair<void*,bool> abtree_ns::abtree<DEGREE,K,Compare,RecManager,INTERNAL_DEGREE,LEAF_DEGREE>::navigate(const int tid, const K& key, const bool forward, const bool inclusive, K * const outKey) {
+    auto guard = recordmgr->getGuard(tid, true);
+    std::vector<RQLeaf>& leaves = rqThreadData[tid].leaves;
+    while (true) {
+        leaves.clear();
+        std::pair<void*,bool> result(NO_VALUE, false);
+        K bound = key;
+        bool below = false;
+        while (true) {
+            K next;
+            bool hasNext;
+            Node<DEGREE,K> * l = rqDescend(tid, bound, below, forward, &next, &hasNext);
+            if (forward) {
+                // the first key >= key (inclusive) or > key
+                const int i = inclusive ? l->getKeyIndex(key, cmp) : l->getChildIndex(key, cmp);
+                if (i < l->getKeyCount()) {
+                    *outKey = l->keys[i];
+                    result = std::pair<void*,bool>(l->ptrs[i], true);
+                    break;
+                }
+            } else {
+                // the last key <= key
+                const int i = l->getChildIndex(key, cmp);
+                if (i > 0) {
+                    *outKey = l->keys[i-1];
+                    result = std::pair<void*,bool>(l->ptrs[i-1], true);
+                    break;
+                }
+            }
+            if (!hasNext) break;
+            bound = next;
+            below = !forward;
+        }
+        // a single leaf needs no check: it was in the tree when it was read, as for find
+        if (leaves.size() == 1 || rqValidate(tid)) return result;
+    }
+}
+
+// sorts the indices of the n keys of a batch by key (stably), and with dedupe,
+// keeps only the first of equal keys
+template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE, int LEAF_DEGREE>
+void abtree_ns::abtree<DEGREE,K,Compare,RecManager,INTERNAL_DEGREE,LEAF_DEGREE>::batchSort(const int tid, const K * const keys, const int n, const bool dedupe) {
+    std::vector<int>& order = batchThreadData[tid].order;
+    order.resize(n);
+    for (int i=0;i<n;++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](const int a, const int b) { return cmp(keys[a], keys[b]); });
+    if (dedupe) {
+        order.erase(std::unique(order.begin(), order.end(), [&](const int a, const int b) { return !cmp(keys[a], keys[b]); }), order.end());
+    }
+    std::vector<BatchStep>& path = batchThreadData[tid].path;
+    path.clear();
+    path.push_back({entry, entry->searchKey, false});
+}
+
+// descends to the leaf whose range contains key, from the deepest node on the
+// batch path whose range contains it (keys must come in increasing order), and
+// extends the path down to the parent of the leaf. sets hi to where the range
+// of the leaf ends, if it is bounded.
+template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE, int LEAF_DEGREE>
+abtree_ns::Node<DEGREE,K> * abtree_ns::abtree<DEGREE,K,Compare,RecManager,INTERNAL_DEGREE,LEAF_DEGREE>::batchDescend(const int tid, const K& key, int * const ixToL, K * const hi, bool * const hasHi) {
+    std::vector<BatchStep>& path = batchThreadData[tid].path;
+    while (path.size() > 1 && path.back().hasHi && !cmp(key, path.back().hi)) {
+        path.pop_back();
+    }
+    Node<DEGREE,K> * p = path.back().node;
+    while (true) {
+        const int ix = p->getChildIndex(key, cmp);
+        if (ix < p->getKeyCount()) {
+            *hi = p->keys[ix];
+            *hasHi = true;
+        } else {
+            *hi = path.back().hi;
+            *hasHi = path.back().hasHi;
+        }
+        Node<DEGREE,K> * l = p->ptrs[ix];
+        if (l->isLeaf()) {
+            *ixToL = ix;
+            return l;
+        }
+        path.push_back({l, *hi, *hasHi});
+        p = l;
+    }
+}
+
+template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE, int LEAF_DEGREE>
+int abtree_ns::abtree<DEGREE,K,Compare,RecManager,INTERNAL_DEGREE,LEAF_DEGREE>::findBatch(const int tid, const K * const keys, const int n, void ** const values) {
+    auto guard = recordmgr->getGuard(tid, true);
+    batchSort(tid, keys, n, false);
+    const std::vector<int>& order = batchThreadData[tid].order;
+    int found = 0;
+    int i = 0;
+    while (i < n) {
+        int ixToL;
+        K hi;
+        bool hasHi;
+        Node<DEGREE,K> * l = batchDescend(tid, keys[order[i]], &ixToL, &hi, &hasHi);
+        const int nkeys = l->getKeyCount();
+        int pos = 0;
+        for (;i < n && (!hasHi || cmp(keys[order[i]], hi));++i) {
+            const K& key = keys[order[i]];
+            while (pos < nkeys && cmp(l->keys[pos], key)) ++pos;
+            if (pos < nkeys && l->keys[pos] == key) {
+                values[order[i]] = l->ptrs[pos];
+                ++found;
+            } else {
+                values[order[i]] = NO_VALUE;
+            }
+        }
+    }
+    return found;
+}
+
+template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE, int LEAF_DEGREE>
+int abtree_ns::abtree<DEGREE,K,Compare,RecManager,INTERNAL_DEGREE,LEAF_DEGREE>::insertBatch(const int tid, const K * const keys, void * const * const values, const int n) {
+    BatchThreadData& data = batchThreadData[tid];
+    batchSort(tid, keys, n, true);
+    const std::vector<int>& order = data.order;
+    const int m = order.size();
+    // the most keys the leaves below one new internal node can hold
+    const int maxKeys = INTERNAL_DEGREE * LEAF_DEGREE;
+    data.keys.resize(maxKeys);
+    data.values.resize(maxKeys);
+    K * const newKeys = data.keys.data();
+    Node<DEGREE,K> ** const newPtrs = data.values.data();
+
+    // the nodes on the batch path must not be freed between two leaves,
+    // so the whole batch is one operation (restarted only to deallocate)
+    recordmgr->startOp(tid);
+    int inserted = 0;
+    int i = 0;
+    while (i < m) {
+        int ixToL;
+        K hi;
+        bool hasHi;
+        Node<DEGREE,K> * l = batchDescend(tid, keys[order[i]], &ixToL, &hi, &hasHi);
+        Node<DEGREE,K> * p = data.path.back().node;
+
+        /**
+         * merge the keys of l with the keys of the batch in its range
+         * that it does not contain (up to maxKeys keys in total)
+         */
+        const int nkeys = l->getKeyCount();
+        int size = 0;
+        int added = 0;
+        int pos = 0;
+        int j = i;
+        for (;j < m && (!hasHi || cmp(keys[order[j]], hi));++j) {
+            const K& key = keys[order[j]];
+            while (pos < nkeys && cmp(l->keys[pos], key)) {
+                newKeys[size] = l->keys[pos];
+                newPtrs[size++] = l->ptrs[pos++];
+            }
+            if (pos < nkeys && l->keys[pos] == key) continue; // already in the tree
+            if (size + (nkeys - pos) >= maxKeys) break; // the rest waits for the next round
+            newKeys[size] = key;
+            newPtrs[size++] = (Node<DEGREE,K> *) values[order[j]];
+            ++added;
+        }
+        while (pos < nkeys) {
+            newKeys[size] = l->keys[pos];
+            newPtrs[size++] = l->ptrs[pos++];
+        }
+        if (added == 0) {
+            i = j;
+            continue;
+        }
+
+        prov->scxInit(tid);
+        auto llxResult = prov->llx(tid, p);
+        if (!prov->isSuccessfulLLXResult(llxResult) || p->ptrs[ixToL] != l) {
+            data.path.resize(1); // p changed: descend again from the root
+            continue;
+        }
+        prov->scxAddNode(tid, p, false, llxResult);
+        // no need to add l, since it is a leaf, and leaves are IMMUTABLE (so no point freezing or finalizing them)
+
+        // create new node(s): the merged keys spread evenly over as few
+        // leaves as hold them, below a new internal node if there are several
+        const int nleaves = (size + LEAF_DEGREE - 1) / LEAF_DEGREE;
+        Node<DEGREE,K> * leaves[INTERNAL_DEGREE] = {};
+        for (int k=0;k<nleaves;++k) {
+            const int first = size * k / nleaves;
+            const int count = size * (k+1) / nleaves - first;
+            Node<DEGREE,K> * leaf = allocateNode(tid);
+            arraycopy(newKeys, first, leaf->keys, 0, count);
+            arraycopy(newPtrs, first, leaf->ptrs, 0, count);
+            leaf->leaf = true;
+            leaf->searchKey = (nleaves == 1) ? l->searchKey : newKeys[first];
+            leaf->size = count;
+            leaf->weight = true;
+            leaves[k] = leaf;
+        }
+        Node<DEGREE,K> * newNode = leaves[0];
+        if (nleaves > 1) {
+            newNode = allocateNode(tid);
+            for (int k=0;k<nleaves;++k) {
+                newNode->ptrs[k] = leaves[k];
+                if (k > 0) newNode->keys[k-1] = leaves[k]->keys[0];
+            }
+            newNode->leaf = false;
+            newNode->searchKey = newNode->keys[0];
+            newNode->size = nleaves;
+            newNode->weight = p == entry; // as for an overflow (Root-Zero if newNode becomes the root)
+        }
+
+        if (prov->scxExecute(tid, (void * volatile *) &p->ptrs[ixToL], l, newNode)) {
+            recordmgr->retire(tid, l);
+            inserted += added;
+            i = j;
+            if (nleaves == 1) {
+                fixDegreeViolation(tid, newNode);
+            } else {
+                // newNode has a weight violation, and fixing it replaces p
+                fixWeightViolation(tid, newNode);
+                if (data.path.size() > 1) data.path.pop_back();
+            }
+            continue;
+        }
+        recordmgr->endOp(tid);
+        for (int k=0;k<nleaves;++k) {
+            this->recordmgr->deallocate(tid, leaves[k]);
+        }
+        if (nleaves > 1) this->recordmgr->deallocate(tid, newNode);
+        recordmgr->startOp(tid);
+        data.path.resize(1);
+    }
+    recordmgr->endOp(tid);
+    return inserted;
 }
 
 
-template <int DEGREE, typename K, class Compare, class RecManager>
-void* abtree_ns::abtree<DEGREE,K,Compare,RecManager>::doInsert(const int tid, const K& key, void * const value, const bool replace) {
+template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE, int LEAF_DEGREE>
+void abtree_ns::abtree<DEGREE,K,Compare,RecManager,INTERNAL_DEGREE,LEAF_DEGREE>::bulkLoad(const int numThreads, const K * const keys, void * const * const values, const size_t n, const double fillFactor) {
+    Node<DEGREE,K> * oldRoot = entry->ptrs[0];
+    if (!oldRoot->isLeaf() || oldRoot->getKeyCount() > 0) {
+        setbench_error("bulkLoad requires an empty tree");
+    }
+    if (numThreads < 1 || numThreads > NUM_PROCESSES) {
+        setbench_error("bulkLoad needs between 1 and " << NUM_PROCESSES << " threads, not " << numThreads);
+    }
+    if (n == 0) return;
+
+    // every node gets fanout children (or keys), except that sizes are evened out
+    // over each level so that no node falls below a (the last one included)
+    auto getFanout = [fillFactor](const int b, const int a) {
+        return std::min(b, std::max(2*a, (int) (fillFactor * b + 0.5)));
+    };
+    int fanout = getFanout(LEAF_DEGREE, aLeaf);
+
+    // run f(tid, begin, end) on numThreads slices of [0, count). a tid that
+    // is not registered is registered for the slice only, and one that is
+    // (e.g., tid 0 by the constructor) stays registered.
+    auto parallelFor = [numThreads, this](const size_t count, auto f) {
+        std::vector<std::thread> threads;
+        for (int tid=0;tid<numThreads;++tid) {
+            threads.emplace_back([=]() {
+                const bool registered = this->init[tid];
+                if (!registered) this->initThread(tid);
+                f(tid, count * tid / numThreads, count * (tid+1) / numThreads);
+                if (!registered) this->deinitThread(tid);
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+    };
+
+    std::atomic<bool> sorted(true);
+    parallelFor(n, [&](const int tid, const size_t begin, const size_t end) {
+        for (size_t i=std::max(begin, (size_t) 1);i<end;++i) {
+            if (!cmp(keys[i-1], keys[i])) { sorted = false; break; }
+        }
+    });
+    if (!sorted) {
+        setbench_error("bulkLoad requires strictly increasing keys");
+    }
+
+    // leaves: leaf j holds keys [j*n/numNodes, (j+1)*n/numNodes)
+    size_t numNodes = (n + fanout - 1) / fanout;
+    std::vector<Node<DEGREE,K> *> level(numNodes);
+    std::vector<K> minKeys(numNodes);
+    parallelFor(numNodes, [&](const int tid, const size_t begin, const size_t end) {
+        for (size_t j=begin;j<end;++j) {
+            const size_t first = j * n / numNodes;
+            const int size = (int) ((j+1) * n / numNodes - first);
+            Node<DEGREE,K> * leaf = allocateNode(tid);
+            arraycopy(keys, first, leaf->keys, 0, size);
+            for (int i=0;i<size;++i) {
+                leaf->ptrs[i] = (Node<DEGREE,K> *) values[first+i];
+            }
+            leaf->leaf = true;
+            leaf->weight = true;
+            leaf->size = size;
+            leaf->searchKey = keys[first];
+            level[j] = leaf;
+            minKeys[j] = keys[first];
+        }
+    });
+
+    // internal levels: node j gets children [j*numChildren/numNodes, (j+1)*numChildren/numNodes)
+    fanout = getFanout(INTERNAL_DEGREE, aInternal);
+    while (level.size() > 1) {
+        const size_t numChildren = level.size();
+        numNodes = (numChildren + fanout - 1) / fanout;
+        std::vector<Node<DEGREE,K> *> parents(numNodes);
+        std::vector<K> parentMinKeys(numNodes);
+        parallelFor(numNodes, [&](const int tid, const size_t begin, const size_t end) {
+            for (size_t j=begin;j<end;++j) {
+                const size_t first = j * numChildren / numNodes;
+                const int size = (int) ((j+1) * numChildren / numNodes - first);
+                Node<DEGREE,K> * node = allocateNode(tid);
+                arraycopy(level, first, node->ptrs, 0, size);
+                arraycopy(minKeys, first+1, node->keys, 0, size-1);
+                node->leaf = false;
+                node->weight = true;
+                node->size = size;
+                node->searchKey = minKeys[first];
+                parents[j] = node;
+                parentMinKeys[j] = minKeys[first];
+            }
+        });
+        level.swap(parents);
+        minKeys.swap(parentMinKeys);
+    }
+
+    entry->ptrs[0] = level[0];
+    const bool registered = init[0];
+    if (!registered) initThread(0);
+    recordmgr->deallocate(0, oldRoot);
+    if (!registered) deinitThread(0);
+}
+
+template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE, int LEAF_DEGREE>
+void* abtree_ns::abtree<DEGREE,K,Compare,RecManager,INTERNAL_DEGREE,LEAF_DEGREE>::doInsert(const int tid, const K& key, void * const value, const bool replace) {
     while (true) {
         /**
          * search
@@ -555,7 +1337,7 @@ void* abtree_ns::abtree<DEGREE,K,Compare,RecManager>::doInsert(const int tid, co
             prov->scxAddNode(tid, p, false, llxResult);
             // no need to add l, since it is a leaf, and leaves are IMMUTABLE (so no point freezing or finalizing them)
 
-            if (l->getKeyCount() < b) {
+            if (l->getKeyCount() < LEAF_DEGREE) {
                 /**
                  * Insert std::pair
                  */
@@ -581,7 +1363,7 @@ void* abtree_ns::abtree<DEGREE,K,Compare,RecManager>::doInsert(const int tid, co
                 guard.end();
                 this->recordmgr->deallocate(tid, n);
 
-            } else { // assert: l->getKeyCount() == DEGREE == b)
+            } else { // assert: l->getKeyCount() == LEAF_DEGREE == b)
                 /**
                  * Overflow
                  */
@@ -603,7 +1385,7 @@ void* abtree_ns::abtree<DEGREE,K,Compare,RecManager>::doInsert(const int tid, co
                 // a parent, and two leaves;
                 // the array contents are then split between the two new leaves
 
-                const int size1 = (DEGREE+1)/2;
+                const int size1 = (LEAF_DEGREE+1)/2;
                 Node<DEGREE,K> * left = allocateNode(tid);
                 arraycopy(keys, 0, left->keys, 0, size1);
                 arraycopy(ptrs, 0, left->ptrs, 0, size1);
@@ -612,7 +1394,7 @@ void* abtree_ns::abtree<DEGREE,K,Compare,RecManager>::doInsert(const int tid, co
                 left->size = size1;
                 left->weight = true;
 
-                const int size2 = (DEGREE+1) - size1;
+                const int size2 = (LEAF_DEGREE+1) - size1;
                 Node<DEGREE,K> * right = allocateNode(tid);
                 arraycopy(keys, size1, right->keys, 0, size2);
                 arraycopy(ptrs, size1, right->ptrs, 0, size2);
@@ -651,8 +1433,8 @@ void* abtree_ns::abtree<DEGREE,K,Compare,RecManager>::doInsert(const int tid, co
     }
 }
 
-template <int DEGREE, typename K, class Compare, class RecManager>
-const std::pair<void*,bool> abtree_ns::abtree<DEGREE,K,Compare,RecManager>::erase(const int tid, const K& key) {
+template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE, int LEAF_DEGREE>
+const std::pair<void*,bool> abtree_ns::abtree<DEGREE,K,Compare,RecManager,INTERNAL_DEGREE,LEAF_DEGREE>::erase(const int tid, const K& key) {
     while (true) {
         /**
          * search
@@ -728,8 +1510,8 @@ const std::pair<void*,bool> abtree_ns::abtree<DEGREE,K,Compare,RecManager>::eras
  *
  */
 
-template <int DEGREE, typename K, class Compare, class RecManager>
-bool abtree_ns::abtree<DEGREE,K,Compare,RecManager>::fixWeightViolation(const int tid, Node<DEGREE,K> * viol) {
+template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE, int LEAF_DEGREE>
+bool abtree_ns::abtree<DEGREE,K,Compare,RecManager,INTERNAL_DEGREE,LEAF_DEGREE>::fixWeightViolation(const int tid, Node<DEGREE,K> * viol) {
     if (viol->weight) return false;
 
     // assert: viol is internal (because leaves always have weight = 1)
@@ -795,7 +1577,7 @@ bool abtree_ns::abtree<DEGREE,K,Compare,RecManager>::fixWeightViolation(const in
         const int c = p->getABDegree() + l->getABDegree();
         const int size = c-1;
 
-        if (size <= b) {
+        if (size <= INTERNAL_DEGREE) {
             /**
              * Absorb
              */
@@ -900,9 +1682,9 @@ bool abtree_ns::abtree<DEGREE,K,Compare,RecManager>::fixWeightViolation(const in
     }
 }
 
-template <int DEGREE, typename K, class Compare, class RecManager>
-bool abtree_ns::abtree<DEGREE,K,Compare,RecManager>::fixDegreeViolation(const int tid, Node<DEGREE,K> * viol) {
-    if (viol->getABDegree() >= a || viol == entry || viol == entry->ptrs[0]) {
+template <int DEGREE, typename K, class Compare, class RecManager, int INTERNAL_DEGREE, int LEAF_DEGREE>
+bool abtree_ns::abtree<DEGREE,K,Compare,RecManager,INTERNAL_DEGREE,LEAF_DEGREE>::fixDegreeViolation(const int tid, Node<DEGREE,K> * viol) {
+    if (viol->getABDegree() >= minDegree(viol) || viol == entry || viol == entry->ptrs[0]) {
         return false; // no degree violation at viol
     }
 
@@ -987,7 +1769,7 @@ bool abtree_ns::abtree<DEGREE,K,Compare,RecManager>::fixDegreeViolation(const in
         // assert: l and s are either both leaves or both internal nodes
         //         (because there are no weight violations at these nodes)
 
-        // also note that p->size >= a >= 2
+        // also note that p->size >= aInternal >= 2
 
         Node<DEGREE,K> * left;
         Node<DEGREE,K> * right;
@@ -1021,7 +1803,7 @@ bool abtree_ns::abtree<DEGREE,K,Compare,RecManager>::fixDegreeViolation(const in
         int sz = left->getABDegree() + right->getABDegree();
         assert(left->weight && right->weight);
 
-        if (sz < 2*a) {
+        if (sz < 2*minDegree(left)) {
             /**
              * AbsorbSibling
              */
@@ -119,7 +119,21 @@ public:
 //        //return std::std::pair<V,bool>(retval, retval != getNoValue());
         return tree->find(tid, key);
     }
-    int rangeQuery(const int tid, const K& lo, const K& hi, K * const resultKeys, V * const resultValues) {
+    // the value of the largest key <= key (predecessor), the smallest key > key
+    // (successor) or the smallest key >= key (lowerBound), and that key in
+    // outKey, or getNoValue() if there is none. not linearizable (see
+    // natarajan_ext_bst_lf::predecessor)
+    #define DS_ADAPTER_SUPPORTS_ORDERED_SEARCH
+    V predecessor(const int tid, const K& key, K * const outKey) {
+        return tree->predecessor(tid, key, outKey);
+    }
+    V successor(const int tid, const K& key, K * const outKey) {
+        return tree->successor(tid, key, outKey);
+    }
+    V lowerBound(const int tid, const K& key, K * const outKey) {
+        return tree->lowerBound(tid, key, outKey);
+    }
+    int rangeQuery(const int tid, const K& lo, const K& hi, K * const resultKeys, V * const resultValues, const int capacity) {
         setbench_error("rangeQuery not implemented for this data structure");
     }
     void printSummary() {
@@ -135,6 +149,14 @@ public:
     void debugGCSingleThreaded() {
         tree->debugGetRecMgr()->debugGCSingleThreaded();
     }
+    #define DS_ADAPTER_SUPPORTS_MEMORY_STATS
+    // the size of a node, how many nodes are allocated and not yet freed, how
+    // many of those are retired and waiting to be reclaimed, and how many have
+    // been freed (may be called during a run, see record_manager::getMemoryStats)
+    void getMemoryStats(size_t * const nodeBytes, long long * const outstanding, long long * const limbo, long long * const freed) {
+        *nodeBytes = sizeof(node_t<K, V>);
+        tree->debugGetRecMgr()->getMemoryStats((node_t<K, V> *) NULL, outstanding, limbo, freed);
+    }
 
 #ifdef USE_TREE_STATS
     class NodeHandler {
@@ -271,6 +271,58 @@ public:
         return search(&data,key);
     }
 
+    /**
+     * Ordered lookups: the value of the largest key <= key (predecessor), the
+     * smallest key > key (successor) or the smallest key >= key (lowerBound),
+     * with that key in outKey, or NO_VALUE if there is none. The search goes
+     * down to the leaf where key would be, remembering the last node where it
+     * turned the other way, and if that leaf does not qualify, returns the
+     * rightmost (leftmost) leaf of that node's left (right) subtree. Like find,
+     * it does not synchronize with updates, and the second descent makes it
+     * not linearizable: it can miss a key inserted next to key meanwhile.
+     */
+    sval_t predecessor(const int tid, const skey_t& key, skey_t * const outKey) {
+        return navigate(tid, key, false, true, outKey);
+    }
+
+    sval_t successor(const int tid, const skey_t& key, skey_t * const outKey) {
+        return navigate(tid, key, true, false, outKey);
+    }
+
+    sval_t lowerBound(const int tid, const skey_t& key, skey_t * const outKey) {
+        return navigate(tid, key, true, true, outKey);
+    }
+
+private:
+    sval_t navigate(const int tid, const skey_t& key, const bool forward, const bool inclusive, skey_t * const outKey) {
+        recmgr->startOp(tid);
+        node_t<skey_t, sval_t> * turn = NULL; // where the search last went right (!forward) or left (forward)
+        node_t<skey_t, sval_t> * leaf = NULL;
+        node_t<skey_t, sval_t> * cur = get_left(root);
+        while (cur != NULL) {
+            const bool left = cmp(key, cur->key);
+            node_t<skey_t, sval_t> * next = left ? get_left(cur) : get_right(cur);
+            if (next != NULL && left == forward) turn = cur;
+            leaf = cur;
+            cur = next;
+        }
+        bool found = forward ? (inclusive ? !cmp(leaf->key, key) : cmp(key, leaf->key)) : !cmp(key, leaf->key);
+        if (!found && turn != NULL) {
+            leaf = forward ? get_right(turn) : get_left(turn);
+            for (cur = leaf; cur != NULL; cur = forward ? get_left(cur) : get_right(cur)) leaf = cur;
+            found = true;
+        }
+        // the two largest leaves hold the sentinel keys MAX_KEY - 1 and MAX_KEY
+        sval_t result = NO_VALUE;
+        if (found && cmp(leaf->key, MAX_KEY - 1)) {
+            *outKey = leaf->key;
+            result = leaf->value;
+        }
+        recmgr->endOp(tid);
+        return result;
+    }
+
+public:
     node_t<skey_t, sval_t> * get_root() {
         return root;
     }